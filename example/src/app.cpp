@@ -1,4 +1,5 @@
 #include "klib/string/fixed_string.hpp"
+#include "kvf/mip_generator.hpp"
 #include "kvf/panic.hpp"
 #include "kvf/util.hpp"
 #include "log.hpp"
@@ -6,6 +7,7 @@
 #include "scenes/sprite.hpp"
 #include "scenes/standalone.hpp"
 #include "scenes/triangle.hpp"
+#include "shader_loader.hpp"
 #include <app.hpp>
 #include <imgui.h>
 
@@ -25,6 +27,10 @@ void App::add_factory(klib::CString name) {
 
 void App::run(std::string_view const assets_dir) {
 	m_assets_dir = assets_dir;
+	// installed in the device: ComputeMipMaps images (eg Sprite's texture) get their mips from it.
+	auto const shader_loader = ShaderLoader{m_device->get_device(), m_assets_dir};
+	IMipGenerator::create(m_device.get(), shader_loader.load_spir_v("downsample.comp"));
+
 	m_current_factory = &m_factories.front();
 	m_scene = m_current_factory->create();
 
@@ -34,6 +40,7 @@ void App::run(std::string_view const assets_dir) {
 		m_scene->m_dt = m_delta_time.tick();
 		m_scene->update(command_buffer);
 		draw_error_modal();
+		draw_memory_stats();
 		m_device->render(m_scene->get_render_target(), m_scene->get_render_filter());
 	}
 }
@@ -81,9 +88,20 @@ void App::draw_menu() {
 		}
 		ImGui::EndMenu();
 	}
+	if (ImGui::BeginMenu("Debug")) {
+		ImGui::MenuItem("Memory Stats", nullptr, &m_show_memory_stats);
+		ImGui::EndMenu();
+	}
 	ImGui::EndMainMenuBar();
 }
 
+void App::draw_memory_stats() {
+	if (!m_show_memory_stats) { return; }
+	ImGui::SetNextWindowSize({480.0f, 320.0f}, ImGuiCond_FirstUseEver);
+	if (ImGui::Begin("Memory Stats", &m_show_memory_stats)) { kvf::draw_memory_stats(m_device->get_memory_stats()); }
+	ImGui::End();
+}
+
 void App::draw_error_modal() const {
 	auto& modal = m_scene->m_modal;
 
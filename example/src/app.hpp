@@ -32,6 +32,7 @@ class App {
 
 	void draw_menu();
 	void draw_error_modal() const;
+	void draw_memory_stats();
 
 	UniqueWindow m_window;
 	std::unique_ptr<IRenderDevice> m_device{};
@@ -39,6 +40,7 @@ class App {
 	std::vector<Factory> m_factories{};
 	Factory* m_current_factory{};
 	Modal m_modal{};
+	bool m_show_memory_stats{};
 
 	std::unique_ptr<Scene> m_scene;
 	DeltaTime m_delta_time{};
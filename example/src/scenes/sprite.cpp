@@ -57,10 +57,12 @@ constexpr auto buffer_usage_layout_v = std::array<vk::BufferUsageFlags, 2>{
 
 Sprite::Sprite(gsl::not_null<IRenderDevice*> device, std::string_view assets_dir)
 	: Scene(device, assets_dir), m_color_pass(IRenderPass::create(device, vk::SampleCountFlagBits::e2)),
-	  m_scratch_buffers(IRingBufferAllocator::create(device, buffer_usage_layout_v)), m_vbo(IRenderBuffer::create(device, vbo_ci_v)) {
+	  m_scratch_buffers(IRingBufferAllocator::create(device, buffer_usage_layout_v)), m_descriptor_cache(IDescriptorCache::create(device)),
+	  m_vbo(IRenderBuffer::create(device, vbo_ci_v)) {
 	m_color_pass->set_color_target();
 	m_color_pass->set_depth_target();
 	m_color_pass->clear_color = Color{glm::vec4{0.1f, 0.1f, 0.1f, 1.0f}}.to_linear();
+	m_color_pass->resize_policy = AttachmentResizePolicy{.bucket_size = 128, .keep_high_water = true};
 
 	create_set_layouts();
 	create_pipeline_layout();
@@ -77,11 +79,12 @@ void Sprite::update(vk::CommandBuffer const command_buffer) {
 
 	auto const extent = get_render_device().get_swapchain_image_extent();
 
+	// the scene (and its deferred VBO writes) may have been created after this frame began.
+	get_render_device().flush_deferred_writes();
 	m_color_pass->begin_render(command_buffer, extent);
 
-	auto descriptor_sets = std::array<vk::DescriptorSet, 2>{};
-	if (m_color_pass->allocate_sets(descriptor_sets, m_set_layouts)) {
-		write_descriptor_sets(descriptor_sets, util::to_glm_vec(extent));
+	auto const descriptor_sets = get_descriptor_sets(util::to_glm_vec(extent));
+	if (descriptor_sets[0] && descriptor_sets[1]) {
 		command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *m_pipeline_layout, 0, descriptor_sets, {});
 
 		m_color_pass->bind_graphics_shader(*m_shader);
@@ -157,7 +160,14 @@ void Sprite::create_texture() {
 	if (!klib::read_file_bytes_to(bytes, path.c_str())) { throw Panic{std::format("Failed to load image: {}", path)}; }
 	auto const image = ImageBitmap{bytes};
 	if (!image.is_loaded()) { throw Panic{"Failed to load image: awesomeface.png"}; }
-	m_texture = IRenderImage::create_texture(&get_render_device(), image.bitmap());
+	// mips are generated by the app's IMipGenerator.
+	auto const ici = ImageCreateInfo{
+		.format = vk::Format::eR8G8B8A8Srgb,
+		.flags = ImageFlag::MipMaps | ImageFlag::ComputeMipMaps,
+		.extent = util::to_vk_extent(image.bitmap().size),
+	};
+	m_texture = IRenderImage::create(&get_render_device(), ici);
+	if (!m_texture->resize_and_overwrite(image.bitmap())) { throw Panic{"Failed to write to Image"}; }
 
 	auto const sci = util::create_sampler_ci(vk::SamplerAddressMode::eRepeat, vk::Filter::eLinear);
 	m_sampler = get_render_device().create_sampler(sci);
@@ -168,11 +178,11 @@ void Sprite::write_vbo() {
 	quad.resize(glm::vec2{100.0f});
 
 	auto const vertices = std::span{quad.vertices};
-	if (!m_vbo->write_in_place(vertices)) { throw Panic{"Failed to write vertices to Buffer"}; }
+	if (!m_vbo->write_in_place(vertices, 0, BufferWriteMode::Deferred)) { throw Panic{"Failed to write vertices to Buffer"}; }
 
 	m_index_offset = vertices.size_bytes();
 	auto const indices = std::span{quad.indices};
-	if (!m_vbo->write_in_place(indices, m_index_offset)) { throw Panic{"Failed to write indices to Buffer"}; }
+	if (!m_vbo->write_in_place(indices, m_index_offset, BufferWriteMode::Deferred)) { throw Panic{"Failed to write indices to Buffer"}; }
 }
 
 void Sprite::create_instances() {
@@ -189,7 +199,7 @@ void Sprite::create_instances() {
 	}
 }
 
-void Sprite::write_descriptor_sets(std::span<vk::DescriptorSet const, 2> sets, glm::vec2 const extent) {
+auto Sprite::get_descriptor_sets(glm::vec2 const extent) -> std::array<vk::DescriptorSet, 2> {
 	auto const buffers = m_scratch_buffers->allocate_next();
 	KLIB_ASSERT(buffers.size() == 2 && buffers[0].get_usage() == vk::BufferUsageFlagBits::eUniformBuffer &&
 				buffers[1].get_usage() == vk::BufferUsageFlagBits::eStorageBuffer);
@@ -197,12 +207,10 @@ void Sprite::write_descriptor_sets(std::span<vk::DescriptorSet const, 2> sets, g
 	auto const& view_ubo = buffers[0];
 	auto const& instances_ssbo = buffers[1];
 
-	auto wds = std::array<vk::WriteDescriptorSet, 3>{};
 	auto const half_extent = 0.5f * extent;
 	auto const projection = glm::ortho(-half_extent.x, half_extent.x, -half_extent.y, half_extent.y);
 	view_ubo.write(projection);
 	auto const view_dbi = view_ubo.descriptor_info();
-	wds[0] = util::ubo_write(&view_dbi, sets[0], 0);
 
 	m_instance_buffer.clear();
 	m_instance_buffer.reserve(m_instances.size());
@@ -213,11 +221,15 @@ void Sprite::write_descriptor_sets(std::span<vk::DescriptorSet const, 2> sets, g
 	}
 	instances_ssbo.write(std::span{m_instance_buffer});
 	auto const instances_dbi = instances_ssbo.descriptor_info();
-	wds[1] = util::ssbo_write(&instances_dbi, sets[1], 0);
 
 	auto const texture_dii = m_texture->descriptor_info(*m_sampler);
-	wds[2] = util::image_write(&texture_dii, sets[1], 1);
 
-	get_render_device().get_device().updateDescriptorSets(wds, {});
+	// the scratch buffers cycle through the same handles every few frames: sets are only written the first time around.
+	auto const set_0 = DescriptorBinding{.binding = 0, .type = vk::DescriptorType::eUniformBuffer, .buffers = {&view_dbi, 1}};
+	auto const set_1 = std::array{
+		DescriptorBinding{.binding = 0, .type = vk::DescriptorType::eStorageBuffer, .buffers = {&instances_dbi, 1}},
+		DescriptorBinding{.binding = 1, .type = vk::DescriptorType::eCombinedImageSampler, .images = {&texture_dii, 1}},
+	};
+	return {m_descriptor_cache->get_set(m_set_layouts[0], {&set_0, 1}), m_descriptor_cache->get_set(m_set_layouts[1], set_1)};
 }
 } // namespace kvf::example
@@ -1,5 +1,6 @@
 #pragma once
 #include "kvf/color.hpp"
+#include "kvf/descriptor_cache.hpp"
 #include "kvf/graphics_shader.hpp"
 #include "kvf/render_image.hpp"
 #include "kvf/render_pass.hpp"
@@ -37,10 +38,11 @@ class Sprite : public Scene {
 	void write_vbo();
 	void create_instances();
 
-	void write_descriptor_sets(std::span<vk::DescriptorSet const, 2> sets, glm::vec2 extent);
+	[[nodiscard]] auto get_descriptor_sets(glm::vec2 extent) -> std::array<vk::DescriptorSet, 2>;
 
 	std::unique_ptr<IRenderPass> m_color_pass{};
 	std::shared_ptr<IRingBufferAllocator> m_scratch_buffers{};
+	std::shared_ptr<IDescriptorCache> m_descriptor_cache{};
 
 	std::array<vk::UniqueDescriptorSetLayout, 2> m_set_layout_storage{};
 	std::array<vk::DescriptorSetLayout, 2> m_set_layouts{};
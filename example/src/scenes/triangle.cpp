@@ -6,10 +6,11 @@
 
 namespace kvf::example {
 Triangle::Triangle(gsl::not_null<IRenderDevice*> device, std::string_view assets_dir)
-	: Scene(device, assets_dir), m_color_pass(IRenderPass::create(device, vk::SampleCountFlagBits::e2)) {
+	: Scene(device, assets_dir), m_color_pass(IRenderPass::create(device, vk::SampleCountFlagBits::e2, RenderPassFlag::TransientAttachments)) {
 	m_color_pass->set_color_target();
 	m_color_pass->set_depth_target();
 	m_color_pass->clear_color = Color{glm::vec4{0.1f, 0.1f, 0.1f, 1.0f}}.to_linear();
+	m_color_pass->resize_policy = AttachmentResizePolicy{.bucket_size = 128, .keep_high_water = true};
 	create_pipeline();
 }
 
@@ -0,0 +1,64 @@
+#pragma once
+#include "klib/base_types.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <optional>
+
+namespace kvf {
+/// \brief Index into the bindless sampled image array.
+enum struct TextureIndex : std::uint32_t {};
+/// \brief Index into the bindless sampler array.
+enum struct SamplerIndex : std::uint32_t {};
+
+struct BindlessTableCreateInfo {
+	static constexpr std::uint32_t max_textures_v{4096};
+	static constexpr std::uint32_t max_samplers_v{64};
+
+	/// \brief Clamped to the device's update-after-bind limits.
+	std::uint32_t max_textures{max_textures_v};
+	std::uint32_t max_samplers{max_samplers_v};
+};
+
+struct BindlessTableStats {
+	std::uint32_t textures{};
+	std::uint32_t max_textures{};
+	std::uint32_t samplers{};
+	std::uint32_t max_samplers{};
+};
+
+/// \brief Device owned descriptor sets (one per FrameIndex) with a partially bound, update-after-bind sampled image array and sampler array:
+///
+/// layout (set = N, binding = 0) uniform texture2D textures[];
+/// layout (set = N, binding = 1) uniform sampler samplers[];
+///
+/// Registered images keep their index for as long as they are registered: views replaced by resize / recreate / defragmentation
+/// are rewritten into each frame's set once that frame's fence has been waited on (after defragmentation), and before it is submitted.
+/// Images are sampled in ShaderReadOnlyOptimal layout.
+/// Indices of removed entries are recycled once the frames that could have used them have completed.
+class IBindlessTable : public klib::Polymorphic {
+  public:
+	using CreateInfo = BindlessTableCreateInfo;
+
+	static constexpr std::uint32_t texture_binding_v{0};
+	static constexpr std::uint32_t sampler_binding_v{1};
+
+	[[nodiscard]] virtual auto get_set_layout() const -> vk::DescriptorSetLayout = 0;
+	/// \brief Set for the current frame: bind it every frame.
+	[[nodiscard]] virtual auto get_set() const -> vk::DescriptorSet = 0;
+	void bind(vk::CommandBuffer command_buffer, vk::PipelineLayout pipeline_layout, std::uint32_t set,
+			  vk::PipelineBindPoint bind_point = vk::PipelineBindPoint::eGraphics) const;
+
+	/// \brief Register image (which must outlive its registration).
+	/// \returns std::nullopt if the table is full.
+	[[nodiscard]] virtual auto add_texture(IRenderImage const& image) -> std::optional<TextureIndex> = 0;
+	virtual void remove_texture(TextureIndex index) = 0;
+
+	/// \brief Register sampler (which must outlive its registration).
+	/// \returns std::nullopt if the table is full.
+	[[nodiscard]] virtual auto add_sampler(vk::Sampler sampler) -> std::optional<SamplerIndex> = 0;
+	virtual void remove_sampler(SamplerIndex index) = 0;
+
+	[[nodiscard]] virtual auto get_stats() const -> BindlessTableStats = 0;
+};
+} // namespace kvf
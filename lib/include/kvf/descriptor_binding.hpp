@@ -0,0 +1,33 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <span>
+
+namespace kvf {
+/// \brief Contents of one binding: buffers or images, according to type.
+struct DescriptorBinding {
+	std::uint32_t binding{};
+	vk::DescriptorType type{};
+	std::span<vk::DescriptorBufferInfo const> buffers{};
+	std::span<vk::DescriptorImageInfo const> images{};
+
+	/// \returns Write with descriptorCount == 0 if there are no buffers / images.
+	[[nodiscard]] auto to_write(vk::DescriptorSet const set = {}) const -> vk::WriteDescriptorSet {
+		auto ret = vk::WriteDescriptorSet{};
+		ret.setDstSet(set).setDstBinding(binding).setDescriptorType(type);
+		if (!buffers.empty()) {
+			ret.setBufferInfo(buffers);
+		} else if (!images.empty()) {
+			ret.setImageInfo(images);
+		}
+		return ret;
+	}
+};
+
+/// \brief Set layout for IRenderPass::push_descriptors() (see IRenderDevice::create_push_set_layout()).
+struct PushSetLayout {
+	vk::UniqueDescriptorSetLayout layout{};
+	/// \brief Whether layout is a push descriptor layout: false without push descriptors, or if it has more than maxPushDescriptors.
+	bool push{};
+};
+} // namespace kvf
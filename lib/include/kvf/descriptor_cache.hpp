@@ -0,0 +1,51 @@
+#pragma once
+#include "klib/base_types.hpp"
+#include "kvf/descriptor_binding.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <gsl/pointers>
+#include <memory>
+#include <span>
+
+namespace kvf {
+struct DescriptorCacheStats {
+	std::size_t sets{};
+	std::size_t pools{};
+	std::uint64_t hits{};
+	std::uint64_t misses{};
+};
+
+struct DescriptorCacheCreateInfo {
+	static constexpr std::uint32_t sets_per_pool_v{64};
+	static constexpr std::uint32_t max_unused_frames_v{120};
+
+	/// \brief Descriptors per pool (empty: uniform / storage buffers and combined image samplers).
+	std::span<vk::DescriptorPoolSize const> pool_sizes{};
+	std::uint32_t sets_per_pool{sets_per_pool_v};
+	/// \brief Frames a set is kept for after its last use.
+	std::uint32_t max_unused_frames{max_unused_frames_v};
+};
+
+/// \brief Descriptor sets keyed by layout and binding contents: a set is allocated and written only the first time a key is seen.
+/// Sets are freed once unused for max_unused_frames (and no longer in flight).
+/// Sets referencing buffers / images created via IRenderBuffer / IRenderImage are dropped when those are destroyed, replaced or relocated,
+/// since their handles may be recycled. Other handles (samplers, custom image views) must outlive the cache, or call clear().
+class IDescriptorCache : public klib::Polymorphic {
+  public:
+	using CreateInfo = DescriptorCacheCreateInfo;
+
+	[[nodiscard]] static auto create(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info = {})
+		-> std::shared_ptr<IDescriptorCache>;
+
+	[[nodiscard]] virtual auto get_render_device() const -> IRenderDevice& = 0;
+
+	/// \brief Get a set of layout with bindings written: cached if the same layout and bindings were requested recently.
+	/// \returns Null handle if allocation failed.
+	[[nodiscard]] virtual auto get_set(vk::DescriptorSetLayout layout, std::span<DescriptorBinding const> bindings) -> vk::DescriptorSet = 0;
+	/// \brief Drop all cached sets (freed once no longer in flight).
+	virtual void clear() = 0;
+
+	[[nodiscard]] virtual auto get_stats() const -> DescriptorCacheStats = 0;
+};
+} // namespace kvf
@@ -9,7 +9,8 @@ using BufferUsageLayout = std::span<vk::BufferUsageFlags const>;
 
 class FixedUsageBuffer {
   public:
-	explicit FixedUsageBuffer(gsl::not_null<IRenderDevice*> device, vk::BufferUsageFlags usage, BufferType type = BufferType::Host);
+	explicit FixedUsageBuffer(gsl::not_null<IRenderDevice*> device, vk::BufferUsageFlags usage, BufferType type = BufferType::Host,
+							  MemoryCategory category = MemoryCategory::Auto);
 
 	[[nodiscard]] auto get_render_device() const -> IRenderDevice& { return m_buffer->get_render_device(); }
 
@@ -20,6 +21,8 @@ class FixedUsageBuffer {
 	void write_contiguous(std::span<BufferWrite const> buffer_writes) const;
 
 	[[nodiscard]] auto get_buffer() const -> vk::Buffer;
+	[[nodiscard]] auto get_size() const -> vk::DeviceSize;
+	[[nodiscard]] auto get_capacity() const -> vk::DeviceSize;
 	[[nodiscard]] auto descriptor_info() const -> vk::DescriptorBufferInfo;
 
   private:
@@ -0,0 +1,68 @@
+#pragma once
+#include "klib/base_types.hpp"
+#include "kvf/buffer_write.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <gsl/pointers>
+#include <memory>
+#include <span>
+
+namespace kvf {
+/// \brief Sub-range of a frame arena buffer, valid until the same FrameIndex comes around again.
+struct BufferSlice {
+	vk::Buffer buffer{};
+	vk::DeviceSize offset{};
+	vk::DeviceSize size{};
+	std::span<std::byte> mapped{};
+	/// \brief Device address of the start of the slice.
+	vk::DeviceAddress device_address{};
+
+	/// \brief Descriptor info for the whole slice (non-dynamic descriptors).
+	[[nodiscard]] auto descriptor_info() const -> vk::DescriptorBufferInfo { return vk::DescriptorBufferInfo{buffer, offset, size}; }
+	/// \brief Descriptor info for dynamic descriptors: offset is supplied at bind time via get_dynamic_offset().
+	[[nodiscard]] auto dynamic_descriptor_info(vk::DeviceSize const range) const -> vk::DescriptorBufferInfo {
+		return vk::DescriptorBufferInfo{buffer, 0, range};
+	}
+	[[nodiscard]] auto get_dynamic_offset() const -> std::uint32_t { return std::uint32_t(offset); }
+
+	[[nodiscard]] explicit operator bool() const { return buffer && size > 0; }
+};
+
+struct FrameArenaCreateInfo {
+	static constexpr vk::DeviceSize block_size_v{4 * 1024 * 1024};
+	static constexpr std::uint64_t trim_frames_v{300};
+
+	vk::BufferUsageFlags usage{vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer};
+	vk::DeviceSize block_size{block_size_v};
+	/// \brief Frames between shrinking each buffer to the peak usage of its FrameIndex since the last shrink.
+	std::uint64_t trim_frames{trim_frames_v};
+};
+
+/// \brief Per-frame linear allocator over one persistently mapped buffer (BufferType::DeviceMapped) per FrameIndex.
+/// Slices are aligned for use with (dynamic) uniform / storage buffer descriptors:
+/// all slices from the same buffer can share one descriptor set, bound with different dynamic offsets.
+/// A frame that outgrows its buffer chains another one, the next use of that FrameIndex replaces both with a single larger buffer.
+/// Every trim_frames frames, buffers larger than needed shrink back, so a single heavy frame doesn't pin its peak memory for good.
+class IFrameArena : public klib::Polymorphic {
+  public:
+	using CreateInfo = FrameArenaCreateInfo;
+
+	[[nodiscard]] static auto create(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info = {}) -> std::shared_ptr<IFrameArena>;
+
+	[[nodiscard]] virtual auto get_render_device() const -> IRenderDevice& = 0;
+
+	/// \brief Allocate size bytes aligned for descriptors of type.
+	/// \returns Empty slice if size is 0.
+	[[nodiscard]] virtual auto allocate(vk::DeviceSize size, vk::DescriptorType type = vk::DescriptorType::eUniformBufferDynamic) -> BufferSlice = 0;
+
+	/// \brief Allocate and write writes contiguously.
+	auto write(std::span<BufferWrite const> writes, vk::DescriptorType type = vk::DescriptorType::eUniformBufferDynamic) -> BufferSlice;
+	auto write(BufferWrite const write, vk::DescriptorType const type = vk::DescriptorType::eUniformBufferDynamic) -> BufferSlice {
+		return this->write(std::span{&write, 1}, type);
+	}
+
+	/// \brief Shrink each frame's buffer to its peak usage since the last shrink, the next time its FrameIndex comes around.
+	virtual void trim() = 0;
+};
+} // namespace kvf
@@ -0,0 +1,88 @@
+#pragma once
+#include "klib/task/queue.hpp"
+#include "kvf/image_writer.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include "kvf/readback_ring.hpp"
+#include "kvf/render_target.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <gsl/pointers>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kvf {
+struct FrameCaptureCreateInfo {
+	static constexpr std::size_t memory_budget_v{256uz * 1024 * 1024};
+
+	/// \brief Files are written as <directory>/<prefix><index>.<ext>.
+	std::filesystem::path directory{"captures"};
+	std::string prefix{"frame_"};
+	Encoding encoding{Encoding::Png};
+	int jpg_quality{80};
+	/// \brief Capture every Nth call to capture().
+	std::uint32_t interval{1};
+	/// \brief Upper bound of pixel bytes held by pending readbacks and encodes; frames beyond it are dropped.
+	std::size_t memory_budget{memory_budget_v};
+	klib::task::ThreadCount thread_count{2};
+};
+
+struct FrameCaptureStats {
+	std::uint64_t written{};
+	/// \brief Frames skipped due to backpressure (memory budget / busy workers), or recorded into frames that were never submitted.
+	std::uint64_t dropped{};
+	/// \brief Frames that failed to encode or write.
+	std::uint64_t failed{};
+	std::size_t bytes_in_flight{};
+};
+
+/// \brief Snapshots render targets into a readback ring, encodes and writes them on worker threads.
+/// Rendering never waits on capture: frames that cannot be accommodated are dropped and counted.
+class FrameCapture {
+  public:
+	using CreateInfo = FrameCaptureCreateInfo;
+	using Stats = FrameCaptureStats;
+
+	explicit FrameCapture(gsl::not_null<IRenderDevice*> render_device, CreateInfo create_info = {});
+	~FrameCapture();
+
+	FrameCapture(FrameCapture const&) = delete;
+	FrameCapture(FrameCapture&&) = delete;
+	auto operator=(FrameCapture const&) -> FrameCapture& = delete;
+	auto operator=(FrameCapture&&) -> FrameCapture& = delete;
+
+	/// \brief Call once per frame after target has been rendered to.
+	/// \returns true if a capture was recorded into command_buffer.
+	auto capture(vk::CommandBuffer command_buffer, RenderTarget const& target, vk::ImageLayout layout) -> bool;
+	auto capture(vk::CommandBuffer command_buffer, IRenderImage const& image) -> bool;
+
+	[[nodiscard]] auto get_stats() const -> Stats;
+	[[nodiscard]] auto get_create_info() const -> CreateInfo const& { return m_info; }
+
+	/// \brief Block until all enqueued encodes have completed (pending readbacks are not waited on).
+	void wait_idle();
+
+  private:
+	class Task;
+
+	[[nodiscard]] auto should_capture() -> bool;
+	[[nodiscard]] auto reserve(std::size_t size) -> bool;
+	void release(std::size_t size);
+	void on_readback(Bitmap const& bitmap, std::uint64_t index, std::size_t size);
+
+	CreateInfo m_info{};
+	std::shared_ptr<IReadbackRing> m_readback{};
+
+	std::vector<std::unique_ptr<Task>> m_tasks{};
+	std::uint64_t m_frame_count{};
+	std::uint64_t m_next_index{};
+
+	std::atomic<std::uint64_t> m_written{};
+	std::atomic<std::uint64_t> m_dropped{};
+	std::atomic<std::uint64_t> m_failed{};
+	std::atomic<std::size_t> m_bytes_in_flight{};
+
+	klib::task::Queue m_queue;
+};
+} // namespace kvf
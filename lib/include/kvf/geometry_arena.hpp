@@ -0,0 +1,79 @@
+#pragma once
+#include "klib/base_types.hpp"
+#include "kvf/buffer_write.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include "kvf/upload_queue.hpp"
+#include <vulkan/vulkan.hpp>
+#include <cstdint>
+#include <gsl/pointers>
+#include <memory>
+#include <optional>
+#include <span>
+
+namespace kvf {
+/// \brief Handle to a mesh in an IGeometryArena. MeshId{} is never valid.
+enum struct MeshId : std::uint64_t {};
+
+/// \brief Ranges of a mesh, in vertices / indices: pass straight to drawIndexed().
+struct MeshRange {
+	std::int32_t vertex_offset{};
+	std::uint32_t vertex_count{};
+	std::uint32_t first_index{};
+	std::uint32_t index_count{};
+};
+
+struct GeometryArenaStats {
+	std::size_t meshes{};
+	std::uint32_t vertices_used{};
+	std::uint32_t vertex_capacity{};
+	std::uint32_t indices_used{};
+	std::uint32_t index_capacity{};
+};
+
+struct GeometryArenaCreateInfo {
+	static constexpr std::uint32_t vertex_capacity_v{64 * 1024};
+	static constexpr std::uint32_t index_capacity_v{3 * vertex_capacity_v};
+
+	/// \brief Size of one vertex in bytes, shared by all meshes in the arena.
+	std::uint32_t vertex_stride{};
+	std::uint32_t vertex_capacity{vertex_capacity_v};
+	std::uint32_t index_capacity{index_capacity_v};
+};
+
+/// \brief Device local vertex + index buffer shared by many meshes (uint32 indices only).
+/// Vertex and index ranges are sub-allocated in units of elements by TLSF allocators (VMA virtual blocks),
+/// so mesh offsets are usable directly as vertexOffset / firstIndex with the arena bound once.
+/// Uploads go through the device's IUploadQueue. Growing and compact() rebuild the buffer (blocking on pending uploads):
+/// ranges must be re-queried and the arena re-bound afterwards. Not thread safe: use on the render thread.
+class IGeometryArena : public klib::Polymorphic {
+  public:
+	using CreateInfo = GeometryArenaCreateInfo;
+
+	[[nodiscard]] static auto create(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info) -> std::shared_ptr<IGeometryArena>;
+
+	[[nodiscard]] virtual auto get_render_device() const -> IRenderDevice& = 0;
+
+	/// \brief Allocate ranges for and enqueue upload of vertices and indices (relative to the mesh's first vertex).
+	/// \returns Handle to the mesh, if vertices is a non-empty multiple of the vertex stride and the arena can grow to fit it.
+	[[nodiscard]] virtual auto upload(BufferWrite vertices, std::span<std::uint32_t const> indices) -> std::optional<MeshId> = 0;
+	/// \brief Release the mesh's ranges once frames in flight have completed. Commands recorded afterwards must not draw it.
+	virtual void free(MeshId id) = 0;
+	/// \brief Move all meshes into tightly packed ranges of a new buffer.
+	virtual void compact() = 0;
+
+	[[nodiscard]] virtual auto get_range(MeshId id) const -> std::optional<MeshRange> = 0;
+	/// \brief Token for the upload of the mesh's data (see IUploadQueue).
+	[[nodiscard]] virtual auto get_token(MeshId id) const -> UploadToken = 0;
+	/// \brief Whether commands recorded now may read the mesh: its upload was submitted when this frame began, or has completed.
+	[[nodiscard]] virtual auto is_drawable(MeshId id) const -> bool = 0;
+	[[nodiscard]] virtual auto get_stats() const -> GeometryArenaStats = 0;
+
+	[[nodiscard]] virtual auto get_buffer() const -> vk::Buffer = 0;
+	[[nodiscard]] virtual auto get_index_offset() const -> vk::DeviceSize = 0;
+
+	/// \brief Bind the arena as vertex buffer (binding) and index buffer.
+	void bind(vk::CommandBuffer command_buffer, std::uint32_t binding = 0) const;
+	/// \brief Draw the mesh (if valid and drawable) with the arena bound.
+	auto draw(vk::CommandBuffer command_buffer, MeshId id, std::uint32_t instance_count = 1, std::uint32_t first_instance = 0) const -> bool;
+};
+} // namespace kvf
@@ -7,6 +7,14 @@ class IRenderBuffer;
 class IRenderImage;
 class IRingBufferAllocator;
 class IRingDescriptorAllocator;
+class IRingDescriptorBuffer;
+class IDescriptorCache;
+class IBindlessTable;
+class IUploadQueue;
+class IRenderTargetPool;
+class IMipGenerator;
+class IFrameArena;
+class IGeometryArena;
 class IGraphicsShader;
 class FixedUsageBuffer;
 class ScratchCommandBuffer;
@@ -0,0 +1,68 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace kvf {
+/// \brief Origin of a buffer / image allocation, for memory accounting.
+enum class MemoryCategory : std::int8_t {
+	/// \brief Deduced from buffer type / image usage at creation.
+	Auto = -1,
+	Other,
+	Texture,
+	RenderTarget,
+	Buffer,
+	RingBuffer,
+	/// \brief Transient host copies, released once the copy completes.
+	Staging,
+	/// \brief Long lived host staging blocks of the upload queue.
+	Upload,
+};
+
+inline constexpr std::size_t memory_category_count_v{7};
+
+[[nodiscard]] constexpr auto to_string_view(MemoryCategory const category) -> std::string_view {
+	switch (category) {
+	case MemoryCategory::Texture: return "Texture";
+	case MemoryCategory::RenderTarget: return "Render Target";
+	case MemoryCategory::Buffer: return "Buffer";
+	case MemoryCategory::RingBuffer: return "Ring Buffer";
+	case MemoryCategory::Staging: return "Staging";
+	case MemoryCategory::Upload: return "Upload";
+	default: return "Other";
+	}
+}
+
+struct MemoryCategoryStats {
+	vk::DeviceSize bytes{};
+	std::size_t allocations{};
+};
+
+struct MemoryHeapStats {
+	vk::DeviceSize size{};
+	/// \brief Estimated memory available to this process (heap size / 80% if VK_EXT_memory_budget is unavailable).
+	vk::DeviceSize budget{};
+	/// \brief Estimated memory used by this process (equal to block_bytes if VK_EXT_memory_budget is unavailable).
+	vk::DeviceSize usage{};
+	/// \brief Bytes of VkDeviceMemory allocated by VMA.
+	vk::DeviceSize block_bytes{};
+	/// \brief Bytes occupied by allocations within those blocks.
+	vk::DeviceSize allocation_bytes{};
+	bool device_local{};
+};
+
+struct MemoryStats {
+	std::vector<MemoryHeapStats> heaps{};
+	/// \brief Indexed by MemoryCategory (excluding Auto).
+	std::array<MemoryCategoryStats, memory_category_count_v> categories{};
+	bool memory_budget_ext{};
+
+	[[nodiscard]] auto get_category(MemoryCategory const category) const -> MemoryCategoryStats const& { return categories.at(std::size_t(category)); }
+};
+
+/// \brief Draw stats into the current ImGui window.
+void draw_memory_stats(MemoryStats const& stats);
+} // namespace kvf
@@ -0,0 +1,28 @@
+#pragma once
+#include "klib/base_types.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include "kvf/render_image.hpp"
+#include <cstdint>
+#include <gsl/pointers>
+#include <memory>
+#include <span>
+
+namespace kvf {
+/// \brief Compute based mip map generation for RGBA8 images created with ImageFlag::ComputeMipMaps.
+/// Box filtered mips are reduced in shared memory, up to mips_per_dispatch_v levels per dispatch (two for a 4K texture);
+/// Kaiser filtered ones need a wider footprint and take one dispatch per level.
+/// Averaging is done in linear space for sRGB formats. Unsupported images fall back to blits.
+class IMipGenerator : public klib::Polymorphic {
+  public:
+	static constexpr std::uint32_t mips_per_dispatch_v{6};
+
+	/// \brief Create a generator and install it in render_device.
+	/// \param spir_v Compute shader compiled from example/glsl/downsample.comp (or one with the same interface).
+	static auto create(gsl::not_null<IRenderDevice*> render_device, std::span<std::uint32_t const> spir_v) -> std::shared_ptr<IMipGenerator>;
+
+	[[nodiscard]] virtual auto is_supported(IRenderImage const& image) const -> bool = 0;
+	/// \brief Record generation of mips [1, N) of all layers from mip 0, followed by a transition to final_layout.
+	/// \returns false if image is not supported (nothing is recorded).
+	virtual auto record(vk::CommandBuffer command_buffer, IRenderImage& image, MipFilter filter, vk::ImageLayout final_layout) -> bool = 0;
+};
+} // namespace kvf
@@ -6,5 +6,7 @@ namespace kvf {
 class INextFrameListener : public klib::Polymorphic {
   public:
 	virtual void on_next_frame(FrameIndex frame_index) = 0;
+	/// \brief Called once the current frame's command buffer has been submitted (frames that fail to acquire a swapchain image are not).
+	virtual void on_frame_submitted() {}
 };
 } // namespace kvf
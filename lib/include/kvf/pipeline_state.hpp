@@ -9,6 +9,8 @@ enum class PipelineFlag : std::uint8_t {
 	None = 0,
 	DepthTest = 1 << 0,
 	DepthWrite = 1 << 1,
+	/// \brief Set layouts are bound via IRingDescriptorBuffer.
+	DescriptorBuffer = 1 << 2,
 };
 constexpr auto enable_enum_bitops(PipelineFlag /*unused*/) { return true; }
 
@@ -0,0 +1,39 @@
+#pragma once
+#include "klib/base_types.hpp"
+#include "kvf/bitmap.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include "kvf/render_target.hpp"
+#include <functional>
+#include <gsl/pointers>
+#include <memory>
+
+namespace kvf {
+/// \brief Receives tightly packed pixels (rowPitch == width * 4) mapped directly from the readback buffer.
+/// bitmap.bytes are only valid for the duration of the call, and empty if the request was dropped.
+using ReadbackCallback = std::function<void(Bitmap const& bitmap)>;
+
+/// \brief Asynchronous image readback via a ring of host visible buffers (one set per FrameIndex).
+/// Copies are recorded into the frame's command buffer, results are delivered when that frame's resources are next reused
+/// (resource_buffering_v frames later), on the render thread, at the start of next_frame().
+/// Requests recorded into frames that were never submitted (eg. minimized window) are dropped: their callbacks receive an empty bitmap.
+class IReadbackRing : public klib::Polymorphic {
+  public:
+	/// \brief Create a ring and attach it to render_device as an INextFrameListener.
+	[[nodiscard]] static auto create(gsl::not_null<IRenderDevice*> render_device) -> std::shared_ptr<IReadbackRing>;
+
+	/// \brief Record a copy of target (mip 0, layer 0) into the current frame's readback buffer.
+	/// \param command_buffer Current frame's command buffer.
+	/// \param target Image with an 8 bit RGBA / BGRA format (target.format), BGRA pixels are swizzled to RGBA.
+	/// \param layout Current layout of target, restored after the copy.
+	/// \param callback Invoked with the pixels once the frame has completed.
+	virtual auto request(vk::CommandBuffer command_buffer, RenderTarget const& target, vk::ImageLayout layout, ReadbackCallback callback) -> bool = 0;
+
+	/// \brief Number of requests that have not been delivered yet.
+	[[nodiscard]] virtual auto get_pending_count() const -> std::size_t = 0;
+	/// \brief Total size of readback buffers across all frames.
+	[[nodiscard]] virtual auto get_allocated_size() const -> vk::DeviceSize = 0;
+
+	/// \brief Validates image aspect / samples / layout before requesting a copy.
+	auto request(vk::CommandBuffer command_buffer, IRenderImage const& image, ReadbackCallback callback) -> bool;
+};
+} // namespace kvf
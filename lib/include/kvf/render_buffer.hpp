@@ -2,13 +2,45 @@
 #include "klib/base_types.hpp"
 #include "kvf/buffer_write.hpp"
 #include "kvf/kvf_fwd.hpp"
+#include "kvf/memory_stats.hpp"
 #include <vulkan/vulkan.hpp>
 #include <cstdint>
 #include <gsl/pointers>
 #include <memory>
 
 namespace kvf {
-enum class BufferType : std::uint8_t { Host, Device };
+enum class BufferType : std::uint8_t {
+	Host,
+	Device,
+	/// \brief Host visible and cached, for reading back from the GPU.
+	Readback,
+	/// \brief Host visible device local memory (resizable BAR) if a large enough heap exists, Host otherwise.
+	/// Always mapped and host coherent: for dynamic data written by the host every frame. See IRenderBuffer::get_placement().
+	DeviceMapped,
+};
+
+/// \brief Memory a buffer was actually allocated from.
+enum class BufferPlacement : std::int8_t {
+	Host,
+	Device,
+	/// \brief Device local and host visible.
+	DeviceMapped,
+};
+
+enum class BufferWriteMode : std::int8_t {
+	/// \brief Device buffers are written through a scratch command buffer, blocking until the copy completes.
+	Immediate,
+	/// \brief Device buffers are written at the start of the next frame's command buffer, without blocking.
+	/// Writes made during a frame can be made visible to it via IRenderDevice::flush_deferred_writes().
+	/// Writes still pending when the buffer is recreated or destroyed are dropped.
+	Deferred,
+};
+
+/// \brief Write at an arbitrary offset into a buffer.
+struct ScatterWrite {
+	vk::DeviceSize offset{};
+	BufferWrite write{};
+};
 
 struct BufferCreateInfo {
 	static constexpr vk::DeviceSize min_size_v{1};
@@ -17,6 +49,7 @@ struct BufferCreateInfo {
 
 	BufferType type{BufferType::Host};
 	vk::DeviceSize size{min_size_v};
+	MemoryCategory category{MemoryCategory::Auto};
 };
 
 class IRenderBuffer : public klib::Polymorphic {
@@ -33,19 +66,27 @@ class IRenderBuffer : public klib::Polymorphic {
 	[[nodiscard]] virtual auto get_type() const -> BufferType = 0;
 	[[nodiscard]] virtual auto get_buffer() const -> vk::Buffer = 0;
 	[[nodiscard]] virtual auto get_mapped_ptr() const -> void* = 0;
+	[[nodiscard]] virtual auto get_placement() const -> BufferPlacement = 0;
+	/// \brief Address for pointer access from shaders (eg via push constants), valid until the buffer is recreated / resized.
+	/// Querying it excludes the buffer from defragmentation (until it is recreated), which would otherwise relocate it.
+	[[nodiscard]] virtual auto get_device_address() const -> vk::DeviceAddress = 0;
 
 	[[nodiscard]] virtual auto get_size() const -> vk::DeviceSize = 0;
 	[[nodiscard]] virtual auto get_capacity() const -> vk::DeviceSize = 0;
 	virtual void resize(vk::DeviceSize size) = 0;
 
-	auto write_in_place(BufferWrite write, vk::DeviceSize offset = 0) -> bool;
-	void resize_overwrite_contiguous(std::span<BufferWrite const> writes);
-	void resize_and_overwrite(BufferWrite write) { resize_overwrite_contiguous({&write, 1}); }
+	auto write_in_place(BufferWrite write, vk::DeviceSize offset = 0, BufferWriteMode mode = BufferWriteMode::Immediate) -> bool;
+	void resize_overwrite_contiguous(std::span<BufferWrite const> writes, BufferWriteMode mode = BufferWriteMode::Immediate);
+	void resize_and_overwrite(BufferWrite write, BufferWriteMode mode = BufferWriteMode::Immediate) { resize_overwrite_contiguous({&write, 1}, mode); }
+	/// \brief Write to multiple (non overlapping) ranges, adjacent ranges are coalesced.
+	/// Device buffers are written through one staging buffer and a single copy with a region per coalesced range.
+	/// \returns false if any ranges overlap or are out of bounds (nothing is written).
+	virtual auto write_scattered(std::span<ScatterWrite const> writes, BufferWriteMode mode = BufferWriteMode::Immediate) -> bool = 0;
 
 	[[nodiscard]] auto get_mapped_span() const -> std::span<std::byte>;
 	[[nodiscard]] auto descriptor_info() const -> vk::DescriptorBufferInfo;
 
   protected:
-	virtual auto write_contiguous(std::span<BufferWrite const> writes, vk::DeviceSize write_size, vk::DeviceSize offset) -> bool = 0;
+	virtual auto write_contiguous(std::span<BufferWrite const> writes, vk::DeviceSize write_size, vk::DeviceSize offset, BufferWriteMode mode) -> bool = 0;
 };
 } // namespace kvf
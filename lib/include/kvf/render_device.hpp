@@ -3,12 +3,17 @@
 #include "klib/enum/bitops.hpp"
 #include "klib/ptr.hpp"
 #include "klib/version.hpp"
+#include "kvf/bindless_table.hpp"
+#include "kvf/descriptor_binding.hpp"
 #include "kvf/frame_index.hpp"
 #include "kvf/gpu.hpp"
+#include "kvf/memory_stats.hpp"
 #include "kvf/next_frame_listener.hpp"
 #include "kvf/pipeline_state.hpp"
 #include "kvf/render_target.hpp"
 #include "kvf/ring_descriptor_allocator.hpp"
+#include "kvf/ring_descriptor_buffer.hpp"
+#include "kvf/upload_queue.hpp"
 #include <GLFW/glfw3.h>
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
@@ -24,6 +29,8 @@ enum class RenderDeviceFlag : std::uint8_t {
 	LinearBackbuffer = 1 << 0,
 	ShaderObjectFeature = 1 << 1,
 	ShaderObjectLayer = 1 << 2,
+	/// \brief Enable VK_EXT_descriptor_buffer if supported (see IRenderDevice::get_descriptor_buffer()).
+	DescriptorBufferFeature = 1 << 3,
 };
 [[maybe_unused]] constexpr auto enable_enum_bitops(RenderDeviceFlag /*unused*/) { return true; }
 
@@ -34,13 +41,54 @@ inline constexpr auto supported_present_modes_v = std::array{
 	vk::PresentModeKHR::eImmediate,
 };
 
+/// \brief Incremental defragmentation of device memory, run at the start of frames.
+/// Copies of each pass are submitted without waiting, ahead of the frame's work, and the next pass starts once they complete;
+/// moved resources get new handles (see IRenderDevice::request_defragmentation()).
+struct DefragPolicy {
+	/// \brief Frames between the start of runs (0: only on request).
+	std::uint32_t interval_frames{};
+	std::uint32_t max_moves_per_pass{32};
+	vk::DeviceSize max_bytes_per_pass{32 * 1024 * 1024};
+};
+
+enum class PoolAlgorithm : std::int8_t {
+	/// \brief No custom pool: allocations go to VMA's default pools.
+	None,
+	/// \brief General purpose (TLSF) allocation within the pool's own blocks.
+	General,
+	/// \brief Linear (stack / free-at-once) allocation: O(1), best for short lived allocations; a ring buffer when max_blocks is 1.
+	Linear,
+};
+
+/// \brief Custom VMA pool for host buffers of one MemoryCategory.
+/// Allocations that do not fit (larger than block_size, or max_blocks reached) fall back to the default pools.
+struct MemoryPoolInfo {
+	PoolAlgorithm algorithm{PoolAlgorithm::None};
+	/// \brief Size of each memory block (0: VMA default).
+	vk::DeviceSize block_size{};
+	/// \brief Maximum number of blocks (0: unlimited).
+	std::uint32_t max_blocks{};
+};
+
 struct RenderDeviceCreateInfo {
 	static constexpr auto sets_per_pool_v{64};
+	static constexpr vk::DeviceSize descriptor_buffer_size_v{1024 * 1024};
 
 	RenderDeviceFlag flags{RenderDeviceFlag::ShaderObjectFeature};
 	std::span<vk::DescriptorPoolSize const> custom_pool_sizes{};
 	std::uint32_t sets_per_pool{sets_per_pool_v};
+	/// \brief Initial size of each frame's descriptor buffer (with RenderDeviceFlag::DescriptorBufferFeature).
+	vk::DeviceSize descriptor_buffer_size{descriptor_buffer_size_v};
 	klib::Ptr<Gpu::Selector const> gpu_selector{nullptr};
+	DefragPolicy defrag{};
+	/// \brief Host staging buffers (MemoryCategory::Staging): transient copies, freed in allocation order.
+	MemoryPoolInfo staging_pool{.algorithm = PoolAlgorithm::Linear, .block_size = 16 * 1024 * 1024};
+	/// \brief Upload queue staging blocks (MemoryCategory::Upload): long lived and reused, freed out of order.
+	MemoryPoolInfo upload_pool{.algorithm = PoolAlgorithm::General, .block_size = 16 * 1024 * 1024};
+	/// \brief Host per-frame buffers (MemoryCategory::RingBuffer): long lived and recreated on growth.
+	MemoryPoolInfo frame_pool{.algorithm = PoolAlgorithm::General, .block_size = 8 * 1024 * 1024};
+	/// \brief Only used if the device supports descriptor indexing.
+	BindlessTableCreateInfo bindless{};
 };
 
 struct ShaderObjectCreateInfo {
@@ -63,7 +111,15 @@ class IRenderDevice : public klib::Polymorphic {
 	[[nodiscard]] virtual auto get_surface() const -> vk::SurfaceKHR = 0;
 	[[nodiscard]] virtual auto get_device() const -> vk::Device = 0;
 	[[nodiscard]] virtual auto get_queue_family() const -> std::uint32_t = 0;
+	/// \brief Same as get_queue_family() if the GPU has no dedicated transfer queue.
+	[[nodiscard]] virtual auto get_transfer_queue_family() const -> std::uint32_t = 0;
 	[[nodiscard]] virtual auto get_allocator() const -> VmaAllocator = 0;
+	/// \brief Per-heap budget / usage (from VK_EXT_memory_budget when available) and totals by MemoryCategory.
+	[[nodiscard]] virtual auto get_memory_stats() const -> MemoryStats = 0;
+	/// \brief Start a defragmentation run at the next frame. Buffers and images created via IRenderBuffer::create() / IRenderImage::create()
+	/// may be relocated: their vk::Buffer / vk::Image / vk::ImageView handles (and device addresses) are only valid until the next frame.
+	/// Host mapped buffers and transient images are never moved.
+	virtual void request_defragmentation() = 0;
 
 	[[nodiscard]] virtual auto get_swapchain_image_extent() const -> vk::Extent2D = 0;
 	[[nodiscard]] virtual auto get_swapchain_color_format() const -> vk::Format = 0;
@@ -83,13 +139,39 @@ class IRenderDevice : public klib::Polymorphic {
 	virtual void attach_next_frame_listener(std::weak_ptr<INextFrameListener> listener) = 0;
 
 	[[nodiscard]] virtual auto get_descriptor_allocator() -> IRingDescriptorAllocator& = 0;
+	/// \brief Null unless RenderDeviceFlag::DescriptorBufferFeature was requested and is supported.
+	[[nodiscard]] virtual auto get_descriptor_buffer() -> klib::Ptr<IRingDescriptorBuffer> = 0;
+	/// \brief Whether VK_KHR_push_descriptor is enabled (see IRenderPass::push_descriptors()).
+	[[nodiscard]] virtual auto has_push_descriptors() const -> bool = 0;
+	[[nodiscard]] virtual auto get_upload_queue() -> IUploadQueue& = 0;
+	[[nodiscard]] virtual auto get_render_target_pool() -> IRenderTargetPool& = 0;
+	/// \brief Null if the device does not support descriptor indexing.
+	[[nodiscard]] virtual auto get_bindless_table() const -> klib::Ptr<IBindlessTable> = 0;
+	/// \brief Used by images with ImageFlag::ComputeMipMaps; null until one is set.
+	[[nodiscard]] virtual auto get_mip_generator() const -> klib::Ptr<IMipGenerator> = 0;
+	virtual void set_mip_generator(std::shared_ptr<IMipGenerator> mip_generator) = 0;
+
+	/// \brief Stage writes into dst at offset, copied at the start of the next frame's command buffer (see BufferWriteMode::Deferred).
+	/// Writes made after next_frame() are copied at the start of the following frame, unless flushed.
+	/// Writes still pending when dst is destroyed are dropped.
+	virtual void defer_write(vk::Buffer dst, std::span<BufferWrite const> writes, vk::DeviceSize offset) = 0;
+	/// \brief Record copies of writes deferred since next_frame() into the current command buffer, visible to commands recorded after it.
+	/// Must be called between next_frame() and render(), outside a rendering scope.
+	virtual void flush_deferred_writes() = 0;
 
 	virtual void queue_submit(vk::SubmitInfo2 const& si, vk::Fence fence = {}) = 0;
+	/// \brief Submit to the dedicated transfer queue (graphics queue if there isn't one).
+	virtual void transfer_queue_submit(vk::SubmitInfo2 const& si, vk::Fence fence = {}) = 0;
 
 	virtual auto next_frame() -> vk::CommandBuffer = 0;
 	virtual auto render(RenderTarget const& render_target, vk::Filter filter = vk::Filter::eLinear) -> bool = 0;
 
+	[[nodiscard]] auto has_dedicated_transfer_queue() const -> bool { return get_transfer_queue_family() != get_queue_family(); }
+
 	[[nodiscard]] auto create_sampler(vk::SamplerCreateInfo create_info) const -> vk::UniqueSampler;
+	/// \brief Layout for IRenderPass::push_descriptors(): a push descriptor layout if supported and its total descriptor count
+	/// is within maxPushDescriptors, a regular one otherwise. A pipeline layout can only contain one push descriptor set layout.
+	[[nodiscard]] auto create_push_set_layout(std::span<vk::DescriptorSetLayoutBinding const> bindings) const -> PushSetLayout;
 	[[nodiscard]] auto create_shader_objects(ShaderObjectCreateInfo const& create_info) const -> std::array<vk::UniqueShaderEXT, 2>;
 	[[nodiscard]] auto create_image_barrier(vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eColor) const -> vk::ImageMemoryBarrier2KHR;
 	[[nodiscard]] auto create_pipeline(vk::PipelineLayout layout, PipelineState const& state, PipelineFormat const& format) const -> vk::UniquePipeline;
@@ -4,6 +4,7 @@
 #include "kvf/bitmap.hpp"
 #include "kvf/color_bitmap.hpp"
 #include "kvf/kvf_fwd.hpp"
+#include "kvf/memory_stats.hpp"
 #include "kvf/render_target.hpp"
 #include <cstdint>
 #include <gsl/pointers>
@@ -15,9 +16,18 @@ enum class ImageFlag : std::int8_t {
 	None = 0,
 	DedicatedAlloc = 1 << 0,
 	MipMaps = 1 << 1,
+	/// \brief Attachment whose contents never leave a render pass: TransientAttachment usage (no implicit usage),
+	/// lazily allocated memory when the device has it.
+	Transient = 1 << 2,
+	/// \brief Generate mip maps with the device's IMipGenerator (if any) instead of blits.
+	/// Adds Storage usage, and MutableFormat for sRGB formats (storage views are UNORM).
+	ComputeMipMaps = 1 << 3,
 };
 constexpr auto enable_enum_bitops(ImageFlag /*unused*/) { return true; }
 
+/// \brief Filter used by compute mip map generation.
+enum class MipFilter : std::int8_t { Box, Kaiser };
+
 struct ImageCreateInfo {
 	static constexpr auto implicit_usage_v = vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
 	static constexpr auto min_extent_v = vk::Extent2D{1, 1};
@@ -31,6 +41,8 @@ struct ImageCreateInfo {
 	vk::ImageViewType view_type{vk::ImageViewType::e2D};
 	ImageFlag flags{};
 	vk::Extent2D extent{min_extent_v};
+	MipFilter mip_filter{MipFilter::Box};
+	MemoryCategory category{MemoryCategory::Auto};
 };
 
 class IRenderImage : public klib::Polymorphic {
@@ -59,6 +71,10 @@ class IRenderImage : public klib::Polymorphic {
 
 	virtual void resize(vk::Extent2D extent) = 0;
 	virtual auto resize_and_overwrite(std::span<Bitmap const> layers) -> bool = 0;
+	/// \brief Overwrite a rect of one mip / layer, preserving the rest of the image.
+	/// Only the footprint of the rect in lower mips is regenerated.
+	/// Image must have contents (use resize_and_overwrite() first), and an RGBA8 format.
+	virtual auto update_region(glm::ivec2 offset, Bitmap const& bitmap, std::uint32_t layer = 0, std::uint32_t mip = 0) -> bool = 0;
 	[[nodiscard]] virtual auto copy_to_bitmap(vk::Extent2D custom_extent = {}) const -> std::optional<ColorBitmap> = 0;
 
 	virtual void transition(vk::CommandBuffer command_buffer, vk::ImageMemoryBarrier2 barrier) = 0;
@@ -67,7 +83,9 @@ class IRenderImage : public klib::Polymorphic {
 
 	[[nodiscard]] auto subresource_range() const -> vk::ImageSubresourceRange;
 
-	[[nodiscard]] auto render_target() const -> RenderTarget { return RenderTarget{.image = get_image(), .view = get_image_view(), .extent = get_extent()}; }
+	[[nodiscard]] auto render_target() const -> RenderTarget {
+		return RenderTarget{.image = get_image(), .view = get_image_view(), .extent = get_extent(), .format = get_format()};
+	}
 
 	[[nodiscard]] auto descriptor_info(vk::Sampler sampler) const -> vk::DescriptorImageInfo;
 };
@@ -1,6 +1,8 @@
 #pragma once
 #include "klib/base_types.hpp"
+#include "klib/enum/bitops.hpp"
 #include "kvf/color_bitmap.hpp"
+#include "kvf/descriptor_binding.hpp"
 #include "kvf/graphics_shader.hpp"
 #include "kvf/kvf_fwd.hpp"
 #include "kvf/pipeline_state.hpp"
@@ -10,13 +12,38 @@
 #include <gsl/pointers>
 
 namespace kvf {
+enum class RenderPassFlag : std::uint8_t {
+	None = 0,
+	/// \brief Use transient (lazily allocated where available) MSAA color and depth images, shared across frames in flight.
+	/// Only applies to attachments whose contents are not needed after the pass: multi-sampled color (when resolved),
+	/// and depth (when depth_store_op is DontCare and there is a color target).
+	TransientAttachments = 1 << 0,
+	/// \brief Acquire color, resolve and depth images from the device's render target pool every frame instead of owning them.
+	/// The render texture is only valid until release_targets() is called, or the frame's resources are reused.
+	PooledTargets = 1 << 1,
+};
+[[maybe_unused]] constexpr auto enable_enum_bitops(RenderPassFlag /*unused*/) { return true; }
+
+/// \brief Attachment capacity policy, avoids reallocating attachments on every extent change (eg while dragging a window edge).
+/// Rendering always covers get_extent() via the render area and viewport, images may be larger (see get_render_uv()).
+struct AttachmentResizePolicy {
+	/// \brief Round capacity up to a multiple of bucket_size (0: exact).
+	std::uint32_t bucket_size{};
+	/// \brief Keep the largest capacity, shrinking to fit only once the extent has been unchanged for shrink_delay frames.
+	bool keep_high_water{};
+	std::uint32_t shrink_delay{120};
+};
+
 class IRenderPass : public klib::Polymorphic {
   public:
 	static constexpr auto samples_v = vk::SampleCountFlagBits::e1;
+	static constexpr auto flags_v = RenderPassFlag::None;
 
-	[[nodiscard]] static auto create(gsl::not_null<IRenderDevice*> render_device, vk::SampleCountFlagBits samples = samples_v) -> std::unique_ptr<IRenderPass>;
+	[[nodiscard]] static auto create(gsl::not_null<IRenderDevice*> render_device, vk::SampleCountFlagBits samples = samples_v, RenderPassFlag flags = flags_v)
+		-> std::unique_ptr<IRenderPass>;
 
 	[[nodiscard]] virtual auto get_render_device() const -> IRenderDevice& = 0;
+	[[nodiscard]] virtual auto get_flags() const -> RenderPassFlag = 0;
 
 	virtual void set_color_target(vk::Format format = vk::Format::eUndefined) = 0; // undefined = RGBA with swapchain color space
 	virtual void set_depth_target() = 0;
@@ -34,24 +61,38 @@ class IRenderPass : public klib::Polymorphic {
 	[[nodiscard]] virtual auto get_samples() const -> vk::SampleCountFlagBits = 0;
 
 	[[nodiscard]] virtual auto get_extent() const -> vk::Extent2D = 0;
+	/// \brief Allocated extent of attachments, >= get_extent().
+	[[nodiscard]] virtual auto get_capacity() const -> vk::Extent2D = 0;
 	[[nodiscard]] virtual auto render_target() const -> RenderTarget const& = 0;
 
 	virtual void begin_render(vk::CommandBuffer command_buffer, vk::Extent2D extent) = 0;
 	[[nodiscard]] virtual auto get_command_buffer() const -> vk::CommandBuffer = 0;
 	virtual auto allocate_sets(std::span<vk::DescriptorSet> out_sets, std::span<vk::DescriptorSetLayout const> sets_layouts) -> bool = 0;
+	/// \brief Bind bindings to set of pipeline_layout: pushed into the command buffer if set_layout is a push descriptor layout,
+	/// otherwise written to a set allocated via allocate_sets(). set_layout must be created via IRenderDevice::create_push_set_layout().
+	virtual auto push_descriptors(vk::PipelineLayout pipeline_layout, std::uint32_t set, PushSetLayout const& set_layout,
+								  std::span<DescriptorBinding const> bindings) -> bool = 0;
 	virtual void end_render() = 0;
+	/// \brief Return pooled targets to the device pool before the frame ends, so passes recorded later can reuse them.
+	/// Call after the last command using the render texture has been recorded. No-op without PooledTargets.
+	virtual void release_targets() = 0;
 
 	[[nodiscard]] auto to_viewport(UvRect n_rect) const -> vk::Viewport;
 	[[nodiscard]] auto to_scissor(UvRect n_rect) const -> vk::Rect2D;
+	/// \brief UV rect of the rendered area within the render texture (uv_rect_v unless capacity exceeds extent).
+	[[nodiscard]] auto get_render_uv() const -> UvRect;
 
 	virtual void bind_graphics_pipeline(vk::Pipeline pipeline) const = 0;
 	virtual void bind_graphics_shader(IGraphicsShader const& shader) const = 0;
 
+	/// \brief The view covers the whole image (get_capacity()): sample within get_render_uv(), texels outside it are undefined.
 	[[nodiscard]] virtual auto render_texture_descriptor_info(vk::Sampler sampler) const -> std::optional<vk::DescriptorImageInfo> = 0;
+	/// \brief Copy the rendered area (get_extent()), scaled to custom_extent if non-zero.
 	[[nodiscard]] virtual auto copy_render_texture(vk::Extent2D custom_extent = {}) const -> std::optional<ColorBitmap> = 0;
 
 	glm::vec4 clear_color{0.0f};
 	vk::ClearDepthStencilValue clear_depth{1.0f, 0};
 	vk::AttachmentStoreOp depth_store_op{vk::AttachmentStoreOp::eDontCare};
+	AttachmentResizePolicy resize_policy{};
 };
 } // namespace kvf
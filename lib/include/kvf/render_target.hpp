@@ -6,5 +6,6 @@ struct RenderTarget {
 	vk::Image image{};
 	vk::ImageView view{};
 	vk::Extent2D extent{};
+	vk::Format format{};
 };
 } // namespace kvf
@@ -0,0 +1,42 @@
+#pragma once
+#include "klib/base_types.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include <vulkan/vulkan.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace kvf {
+/// \brief Pooled images with equal keys are interchangeable.
+struct RenderTargetKey {
+	auto operator==(RenderTargetKey const&) const -> bool = default;
+
+	vk::Format format{};
+	vk::Extent2D extent{};
+	vk::SampleCountFlagBits samples{vk::SampleCountFlagBits::e1};
+	vk::ImageUsageFlags usage{vk::ImageUsageFlagBits::eColorAttachment};
+	vk::ImageAspectFlags aspect{vk::ImageAspectFlagBits::eColor};
+};
+
+struct RenderTargetPoolStats {
+	std::size_t images{};
+	/// \brief Images acquired and not yet released (or returned at the end of their frame).
+	std::size_t in_use{};
+	std::size_t bytes{};
+};
+
+/// \brief Device owned pool of render target images, shared by render passes (and custom users).
+/// Acquired images are returned to the pool when the acquiring frame's resources are next reused (resource_buffering_v frames later).
+/// Images released within a frame are handed out again in the same frame, aliasing passes with disjoint lifetimes.
+/// Images unused for idle_frames_v frames are destroyed. Not thread safe: use on the render thread.
+class IRenderTargetPool : public klib::Polymorphic {
+  public:
+	static constexpr std::uint64_t idle_frames_v{120};
+
+	/// \brief Acquire an image matching key for the current frame. Its contents and layout are undefined.
+	[[nodiscard]] virtual auto acquire(RenderTargetKey const& key) -> IRenderImage& = 0;
+	/// \brief Return image to the pool before the frame ends. Commands recorded afterwards must not access it.
+	virtual void release(IRenderImage const& image) = 0;
+
+	[[nodiscard]] virtual auto get_stats() const -> RenderTargetPoolStats = 0;
+};
+} // namespace kvf
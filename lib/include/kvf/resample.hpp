@@ -0,0 +1,29 @@
+#pragma once
+#include "kvf/bitmap.hpp"
+#include "kvf/color_bitmap.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace kvf {
+enum class ResampleFilter : std::int8_t { Box, Triangle, Lanczos3 };
+
+struct ResampleInfo {
+	ResampleFilter filter{ResampleFilter::Lanczos3};
+	/// \brief Color channels are sRGB encoded: filter in linear space.
+	bool srgb{true};
+	/// \brief Weight color by alpha while filtering (avoids dark fringes around transparent pixels).
+	bool premultiply_alpha{true};
+};
+
+/// \brief Separable CPU resampler (up or down).
+/// \param bitmap Source RGBA bitmap.
+/// \param size Target size.
+/// \param info Filter / color space.
+/// \returns Resampled bitmap (empty if bitmap or size is invalid).
+[[nodiscard]] auto resample(Bitmap const& bitmap, glm::ivec2 size, ResampleInfo const& info = {}) -> ColorBitmap;
+
+/// \brief Build all mip levels below bitmap (level 0), halving each dimension until 1x1.
+/// Level count matches util::compute_mip_levels().
+/// \returns Levels [1, N).
+[[nodiscard]] auto create_mip_chain(Bitmap const& bitmap, ResampleInfo const& info = {}) -> std::vector<ColorBitmap>;
+} // namespace kvf
@@ -1,15 +1,37 @@
 #pragma once
 #include "klib/base_types.hpp"
 #include "kvf/fixed_usage_buffer.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
 namespace kvf {
+struct RingBufferAllocatorStats {
+	/// \brief Buffers alive across all frames.
+	std::size_t buffers{};
+	/// \brief Largest number of layouts allocated by a single frame since creation / the last trim().
+	std::size_t high_water{};
+	/// \brief Capacity of all buffers alive.
+	vk::DeviceSize bytes_reserved{};
+	/// \brief Bytes written into buffers allocated this frame.
+	vk::DeviceSize bytes_used{};
+};
+
+/// \brief Hands out per-frame sets of host buffers (one per usage in layout).
+/// Layouts unused for trim_frames frames are destroyed, so a single heavy frame doesn't pin its peak memory for good.
 class IRingBufferAllocator : public klib::Polymorphic {
   public:
-	[[nodiscard]] static auto create(gsl::not_null<IRenderDevice*> render_device, BufferUsageLayout const& layout) -> std::shared_ptr<IRingBufferAllocator>;
+	static constexpr std::uint64_t trim_frames_v{300};
+
+	[[nodiscard]] static auto create(gsl::not_null<IRenderDevice*> render_device, BufferUsageLayout const& layout, std::uint64_t trim_frames = trim_frames_v)
+		-> std::shared_ptr<IRingBufferAllocator>;
 
 	[[nodiscard]] virtual auto get_render_device() const -> IRenderDevice& = 0;
 
 	[[nodiscard]] virtual auto allocate_next() -> std::span<FixedUsageBuffer const> = 0;
+
+	[[nodiscard]] virtual auto get_stats() const -> RingBufferAllocatorStats = 0;
+	/// \brief Destroy all layouts not allocated by the current frame, except those of frames still in flight.
+	virtual void trim() = 0;
 };
 } // namespace kvf
@@ -0,0 +1,43 @@
+#pragma once
+#include "klib/base_types.hpp"
+#include "kvf/descriptor_binding.hpp"
+#include <vulkan/vulkan.hpp>
+#include <span>
+
+namespace kvf {
+/// \brief Descriptors of a set within the current frame's descriptor buffer.
+struct DescriptorBufferSet {
+	vk::DescriptorSetLayout layout{};
+	vk::DeviceSize offset{};
+	/// \brief Index of the frame's buffer holding the set: 0, or 1 for the overflow buffer.
+	std::uint32_t buffer{};
+};
+
+struct RingDescriptorBufferStats {
+	/// \brief Capacity of the current frame's buffers.
+	vk::DeviceSize bytes_reserved{};
+	/// \brief Bytes allocated this frame.
+	vk::DeviceSize bytes_used{};
+};
+
+/// \brief VK_EXT_descriptor_buffer counterpart of IRingDescriptorAllocator: sets are bump allocated from a host visible buffer per frame,
+/// written via vkGetDescriptorEXT, and bound by offset.
+/// Set layouts must be created with DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT, and pipelines with PipelineFlag::DescriptorBuffer.
+/// If the device supports binding two buffers, each frame also has an overflow buffer (bound at index 1), used once its own runs out of space;
+/// buffers grow the next time the frame slot is reused. Allocation only fails once the overflow buffer is exhausted too.
+class IRingDescriptorBuffer : public klib::Polymorphic {
+  public:
+	[[nodiscard]] virtual auto allocate_next(std::span<DescriptorBufferSet> out_sets, std::span<vk::DescriptorSetLayout const> set_layouts) -> bool = 0;
+	/// \brief Buffer ranges must be explicit (not vk::WholeSize).
+	virtual auto write(DescriptorBufferSet const& set, std::span<DescriptorBinding const> bindings) -> bool = 0;
+	/// \brief Bind the current frame's descriptor buffers to command_buffer.
+	/// Already bound to the frame's command buffer by IRenderDevice::next_frame(); other command buffers must bind them before bind(),
+	/// and rebind them after binding any other descriptor buffers.
+	virtual void bind_buffers(vk::CommandBuffer command_buffer) = 0;
+	/// \brief Set offsets for first_set onwards, into the descriptor buffers bound via bind_buffers().
+	virtual void bind(vk::CommandBuffer command_buffer, vk::PipelineBindPoint bind_point, vk::PipelineLayout pipeline_layout, std::uint32_t first_set,
+					  std::span<DescriptorBufferSet const> sets) = 0;
+
+	[[nodiscard]] virtual auto get_stats() const -> RingDescriptorBufferStats = 0;
+};
+} // namespace kvf
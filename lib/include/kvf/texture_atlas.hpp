@@ -0,0 +1,90 @@
+#pragma once
+#include "klib/ptr.hpp"
+#include "kvf/bitmap.hpp"
+#include "kvf/color_bitmap.hpp"
+#include "kvf/rect.hpp"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace kvf {
+enum struct AtlasId : std::uint32_t {};
+
+struct TextureAtlasCreateInfo {
+	static constexpr auto page_size_v = glm::ivec2{2048};
+
+	glm::ivec2 page_size{page_size_v};
+	/// \brief Border (in pixels) around each image.
+	int padding{2};
+	/// \brief Fill padding with edge pixels (prevents bleeding when sampling with linear filters / mip maps).
+	bool extrude{true};
+	std::uint32_t max_pages{8};
+};
+
+struct AtlasEntry {
+	std::uint32_t page{};
+	/// \brief Pixel rect (top-left origin) within the page, excluding padding.
+	Rect<int> rect{};
+	UvRect uv_rect{};
+};
+
+/// \brief Shelf packer for many Bitmaps into one or more fixed size pages.
+/// Ids are stable across remove() and repack(), entries may not be.
+class TextureAtlas {
+  public:
+	using CreateInfo = TextureAtlasCreateInfo;
+
+	explicit TextureAtlas(CreateInfo const& create_info = {});
+
+	/// \brief Copy bitmap into the first page with space for it.
+	/// \returns Id of added entry, if space was available.
+	auto add(Bitmap const& bitmap) -> std::optional<AtlasId>;
+	/// \brief Release entry. Its space is only reclaimed on repack().
+	auto remove(AtlasId id) -> bool;
+	/// \brief Repack all live entries (tallest first) into as few pages as possible.
+	/// \returns false if entries no longer fit (atlas is left unchanged).
+	auto repack() -> bool;
+	void clear();
+
+	[[nodiscard]] auto get_entry(AtlasId id) const -> klib::Ptr<AtlasEntry const>;
+	[[nodiscard]] auto get_entry_count() const -> std::size_t;
+
+	[[nodiscard]] auto get_page_count() const -> std::size_t { return m_pages.size(); }
+	[[nodiscard]] auto get_page(std::size_t index) const -> Bitmap { return m_pages.at(index).bitmap.bitmap(); }
+
+	/// \brief Pages written to since last clear_dirty() (need to be uploaded again).
+	[[nodiscard]] auto is_dirty(std::size_t page_index) const -> bool { return m_pages.at(page_index).dirty; }
+	void clear_dirty();
+
+	[[nodiscard]] auto get_create_info() const -> CreateInfo const& { return m_info; }
+
+  private:
+	struct Shelf {
+		int y{};
+		int height{};
+		int cursor_x{};
+	};
+
+	struct Page {
+		ColorBitmap bitmap{};
+		std::vector<Shelf> shelves{};
+		int used_height{};
+		bool dirty{};
+	};
+
+	struct Placement {
+		std::uint32_t page{};
+		glm::ivec2 left_top{};
+	};
+
+	[[nodiscard]] auto place(std::vector<Page>& pages, glm::ivec2 size) const -> std::optional<Placement>;
+	[[nodiscard]] auto make_entry(Placement const& placement, glm::ivec2 size) const -> AtlasEntry;
+	void write(Page& page, glm::ivec2 left_top, Bitmap const& bitmap) const;
+	[[nodiscard]] auto read(AtlasEntry const& entry) const -> ColorBitmap;
+
+	CreateInfo m_info{};
+	std::vector<Page> m_pages{};
+	std::vector<std::optional<AtlasEntry>> m_entries{};
+	std::vector<AtlasId> m_free_ids{};
+};
+} // namespace kvf
@@ -0,0 +1,48 @@
+#pragma once
+#include "klib/base_types.hpp"
+#include "kvf/bitmap.hpp"
+#include "kvf/buffer_write.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include <vulkan/vulkan.hpp>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace kvf {
+/// \brief Completion token for an upload. UploadToken{} is always ready.
+enum struct UploadToken : std::uint64_t {};
+
+/// \brief Batches image and buffer uploads into one submission per frame.
+/// Pending uploads are submitted at the start of the next frame (or on flush() / wait()),
+/// image copies go through the dedicated transfer queue when the GPU has one.
+/// Targets are safe to use in any command buffer recorded after the next frame begins, or once is_ready() returns true.
+/// Enqueueing is thread safe, but targets must not be used elsewhere while being enqueued.
+class IUploadQueue : public klib::Polymorphic {
+  public:
+	/// \brief Resize image to match layers (which must all be the same size) and overwrite its contents.
+	/// \returns Token for completion, if layers are valid.
+	virtual auto enqueue(IRenderImage& image, std::span<Bitmap const> layers) -> std::optional<UploadToken> = 0;
+	/// \brief Overwrite a rect of one mip / layer of image, preserving the rest (see IRenderImage::update_region()).
+	/// Always recorded on the graphics queue, after any earlier uploads to image.
+	/// \returns Token for completion, if region is valid.
+	virtual auto enqueue_region(IRenderImage& image, glm::ivec2 offset, Bitmap const& bitmap, std::uint32_t layer = 0, std::uint32_t mip = 0)
+		-> std::optional<UploadToken> = 0;
+	/// \brief Write contiguous bytes into buffer at offset. Host buffers are written immediately.
+	/// \returns Token for completion, if buffer is large enough.
+	virtual auto enqueue(IRenderBuffer& buffer, std::span<BufferWrite const> writes, vk::DeviceSize offset = 0) -> std::optional<UploadToken> = 0;
+
+	/// \brief Submit pending uploads now.
+	/// \returns Token for all uploads enqueued so far.
+	virtual auto flush() -> UploadToken = 0;
+
+	[[nodiscard]] virtual auto is_ready(UploadToken token) const -> bool = 0;
+	/// \brief Block until token is ready (flushes pending uploads if necessary).
+	virtual auto wait(UploadToken token, std::chrono::nanoseconds timeout = std::chrono::seconds{5}) -> bool = 0;
+
+	auto enqueue(IRenderImage& image, Bitmap const& bitmap) -> std::optional<UploadToken> { return enqueue(image, std::span{&bitmap, 1}); }
+	auto enqueue(IRenderBuffer& buffer, BufferWrite const write, vk::DeviceSize const offset = 0) -> std::optional<UploadToken> {
+		return enqueue(buffer, std::span{&write, 1}, offset);
+	}
+};
+} // namespace kvf
@@ -18,6 +18,15 @@ inline constexpr auto linear_formats_v = std::array{vk::Format::eR8G8B8A8Unorm,
 
 [[nodiscard]] constexpr auto is_linear(vk::Format const format) -> bool { return std::ranges::find(linear_formats_v, format) != linear_formats_v.end(); }
 [[nodiscard]] constexpr auto is_srgb(vk::Format const format) -> bool { return std::ranges::find(srgb_formats_v, format) != srgb_formats_v.end(); }
+/// \brief UNORM format with the same layout as an sRGB one (storage views of sRGB images), format itself otherwise.
+[[nodiscard]] constexpr auto to_unorm(vk::Format const format) -> vk::Format {
+	switch (format) {
+	case vk::Format::eR8G8B8A8Srgb: return vk::Format::eR8G8B8A8Unorm;
+	case vk::Format::eB8G8R8A8Srgb: return vk::Format::eB8G8R8A8Unorm;
+	case vk::Format::eA8B8G8R8SrgbPack32: return vk::Format::eA8B8G8R8UnormPack32;
+	default: return format;
+	}
+}
 
 [[nodiscard]] constexpr auto to_string_view(vk::PresentModeKHR const present_mode) -> std::string_view {
 	switch (present_mode) {
@@ -103,6 +112,8 @@ struct ImageViewCreateInfo {
 
 	vk::ImageSubresourceRange subresource{vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
 	vk::ImageViewType type{vk::ImageViewType::e2D};
+	/// \brief Subset of the image's usage valid for this view, empty inherits it (required for views of formats not supporting all of it).
+	vk::ImageUsageFlags usage{};
 };
 [[nodiscard]] auto create_image_view(vk::Device device, ImageViewCreateInfo const& create_info) -> vk::UniqueImageView;
 } // namespace kvf::util
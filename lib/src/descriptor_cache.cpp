@@ -0,0 +1,205 @@
+#include "kvf/descriptor_cache.hpp"
+#include "detail/vma.hpp"
+#include "kvf/constants.hpp"
+#include "kvf/next_frame_listener.hpp"
+#include "kvf/render_device.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace kvf {
+namespace {
+using detail::vma::to_word;
+
+// layout, then per binding: binding / type, counts, and the contents of each info.
+using Key = std::vector<std::uint64_t>;
+
+struct KeyHash {
+	[[nodiscard]] auto operator()(Key const& key) const -> std::size_t {
+		auto ret = std::size_t{};
+		for (auto const word : key) { ret ^= std::hash<std::uint64_t>{}(word) + 0x9e3779b9 + (ret << 6) + (ret >> 2); }
+		return ret;
+	}
+};
+
+class DescriptorCache : public IDescriptorCache, public INextFrameListener {
+  public:
+	explicit DescriptorCache(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info)
+		: m_render_device(render_device), m_sets_per_pool(std::max(create_info.sets_per_pool, 1u)),
+		  m_max_unused_frames(create_info.max_unused_frames), m_release_cursor(detail::get_vma(*render_device).get_release_cursor()) {
+		if (create_info.pool_sizes.empty()) {
+			static constexpr auto descriptors_per_type_v = 2 * CreateInfo::sets_per_pool_v;
+			static constexpr auto pool_sizes_v = std::array{
+				vk::DescriptorPoolSize{vk::DescriptorType::eUniformBuffer, descriptors_per_type_v},
+				vk::DescriptorPoolSize{vk::DescriptorType::eStorageBuffer, descriptors_per_type_v},
+				vk::DescriptorPoolSize{vk::DescriptorType::eCombinedImageSampler, descriptors_per_type_v},
+			};
+			m_pool_sizes = {pool_sizes_v.begin(), pool_sizes_v.end()};
+		} else {
+			m_pool_sizes = {create_info.pool_sizes.begin(), create_info.pool_sizes.end()};
+		}
+	}
+
+	[[nodiscard]] auto get_render_device() const -> IRenderDevice& final { return *m_render_device; }
+
+	[[nodiscard]] auto get_set(vk::DescriptorSetLayout const layout, std::span<DescriptorBinding const> bindings) -> vk::DescriptorSet final {
+		auto lock = std::scoped_lock{m_mutex};
+		retire_released();
+
+		build_key(layout, bindings);
+		if (auto const it = m_entries.find(m_key); it != m_entries.end()) {
+			it->second.last_used = m_frame;
+			++m_hits;
+			return it->second.set;
+		}
+
+		++m_misses;
+		auto entry = Entry{.last_used = m_frame};
+		if (!allocate(layout, entry)) { return {}; }
+		write(entry.set, bindings);
+		for (auto const& binding : bindings) {
+			for (auto const& info : binding.buffers) { entry.handles.push_back(to_word(info.buffer)); }
+			for (auto const& info : binding.images) { entry.handles.push_back(to_word(info.imageView)); }
+		}
+		auto const set = entry.set;
+		m_entries.emplace(m_key, std::move(entry));
+		return set;
+	}
+
+	void clear() final {
+		auto lock = std::scoped_lock{m_mutex};
+		retire_all();
+	}
+
+	[[nodiscard]] auto get_stats() const -> DescriptorCacheStats final {
+		auto lock = std::scoped_lock{m_mutex};
+		return DescriptorCacheStats{.sets = m_entries.size(), .pools = m_pools.size(), .hits = m_hits, .misses = m_misses};
+	}
+
+  private:
+	struct Entry {
+		vk::DescriptorSet set{};
+		vk::DescriptorPool pool{};
+		std::uint64_t last_used{};
+		// buffers and image views referenced by the set.
+		std::vector<std::uint64_t> handles{};
+	};
+
+	void on_next_frame(FrameIndex /*frame_index*/) final {
+		auto lock = std::scoped_lock{m_mutex};
+		++m_frame;
+		std::erase_if(m_entries, [this](auto& pair) {
+			if (pair.second.last_used + m_max_unused_frames >= m_frame) { return false; }
+			m_retired.push_back(std::move(pair.second));
+			return true;
+		});
+		// a set is in flight until the fence of the last frame that used it has been waited on.
+		auto const device = m_render_device->get_device();
+		std::erase_if(m_retired, [&](Entry const& entry) {
+			if (entry.last_used + resource_buffering_v > m_frame) { return false; }
+			device.freeDescriptorSets(entry.pool, entry.set);
+			return true;
+		});
+	}
+
+	void retire_all() {
+		for (auto& [_, entry] : m_entries) { m_retired.push_back(std::move(entry)); }
+		m_entries.clear();
+	}
+
+	// handles of released resources are stale, and may be recycled once destroyed: drop only the sets referencing them.
+	void retire_released() {
+		m_released.clear();
+		if (!detail::get_vma(*m_render_device).get_releases(m_release_cursor, m_released)) {
+			retire_all();
+			return;
+		}
+		if (m_released.empty()) { return; }
+
+		m_released_set.clear();
+		m_released_set.insert(m_released.begin(), m_released.end());
+		std::erase_if(m_entries, [this](auto& pair) {
+			if (std::ranges::none_of(pair.second.handles, [this](std::uint64_t const handle) { return m_released_set.contains(handle); })) { return false; }
+			m_retired.push_back(std::move(pair.second));
+			return true;
+		});
+	}
+
+	void build_key(vk::DescriptorSetLayout const layout, std::span<DescriptorBinding const> bindings) {
+		m_key.clear();
+		m_key.push_back(to_word(layout));
+		for (auto const& binding : bindings) {
+			m_key.push_back((std::uint64_t(binding.binding) << 32) | std::uint64_t(binding.type));
+			m_key.push_back((std::uint64_t(binding.buffers.size()) << 32) | std::uint64_t(binding.images.size()));
+			for (auto const& info : binding.buffers) { m_key.insert(m_key.end(), {to_word(info.buffer), info.offset, info.range}); }
+			for (auto const& info : binding.images) {
+				m_key.insert(m_key.end(), {to_word(info.sampler), to_word(info.imageView), std::uint64_t(info.imageLayout)});
+			}
+		}
+	}
+
+	auto allocate(vk::DescriptorSetLayout const layout, Entry& out) -> bool {
+		auto const device = m_render_device->get_device();
+		auto const try_allocate = [&](vk::DescriptorPool const pool) {
+			auto dsai = vk::DescriptorSetAllocateInfo{};
+			dsai.setDescriptorPool(pool).setSetLayouts(layout);
+			if (device.allocateDescriptorSets(&dsai, &out.set) != vk::Result::eSuccess) { return false; }
+			out.pool = pool;
+			return true;
+		};
+
+		// freed sets leave room in earlier pools: try the most recent one first, then the rest.
+		for (auto it = m_pools.rbegin(); it != m_pools.rend(); ++it) {
+			if (try_allocate(**it)) { return true; }
+		}
+
+		auto dpci = vk::DescriptorPoolCreateInfo{};
+		dpci.setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet).setPoolSizes(m_pool_sizes).setMaxSets(m_sets_per_pool);
+		m_pools.push_back(device.createDescriptorPoolUnique(dpci));
+		if (m_pools.size() > 64) { log.warn("DescriptorCache: {} DescriptorPools allocated", m_pools.size()); }
+		if (try_allocate(*m_pools.back())) { return true; }
+
+		log.warn("DescriptorCache: failed to allocate Descriptor Set (pool sizes too small for layout?)");
+		return false;
+	}
+
+	void write(vk::DescriptorSet const set, std::span<DescriptorBinding const> bindings) {
+		m_writes.clear();
+		for (auto const& binding : bindings) {
+			auto const wds = binding.to_write(set);
+			if (wds.descriptorCount > 0) { m_writes.push_back(wds); }
+		}
+		m_render_device->get_device().updateDescriptorSets(m_writes, {});
+	}
+
+	gsl::not_null<IRenderDevice*> m_render_device;
+	std::vector<vk::DescriptorPoolSize> m_pool_sizes{};
+	std::uint32_t m_sets_per_pool{};
+	std::uint32_t m_max_unused_frames{};
+
+	std::vector<vk::UniqueDescriptorPool> m_pools{};
+	std::unordered_map<Key, Entry, KeyHash> m_entries{};
+	std::vector<Entry> m_retired{};
+	std::uint64_t m_release_cursor{};
+	std::vector<std::uint64_t> m_released{};
+	std::unordered_set<std::uint64_t> m_released_set{};
+	std::uint64_t m_frame{};
+	std::uint64_t m_hits{};
+	std::uint64_t m_misses{};
+
+	Key m_key{};
+	std::vector<vk::WriteDescriptorSet> m_writes{};
+	mutable std::mutex m_mutex{};
+};
+} // namespace
+
+auto IDescriptorCache::create(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info) -> std::shared_ptr<IDescriptorCache> {
+	auto ret = std::make_shared<DescriptorCache>(render_device, create_info);
+	render_device->attach_next_frame_listener(ret);
+	return ret;
+}
+} // namespace kvf
@@ -0,0 +1,202 @@
+#include "detail/bindless_table.hpp"
+#include "detail/vma.hpp"
+#include "klib/debug/assert.hpp"
+#include "kvf/constants.hpp"
+#include "kvf/panic.hpp"
+#include "kvf/render_device.hpp"
+#include "kvf/render_image.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <array>
+
+namespace kvf {
+namespace detail {
+namespace {
+[[nodiscard]] auto clamp_capacities(vk::PhysicalDevice const gpu, BindlessTableCreateInfo create_info) -> BindlessTableCreateInfo {
+	auto const chain = gpu.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingProperties>();
+	auto const& limits = chain.get<vk::PhysicalDeviceDescriptorIndexingProperties>();
+	auto const max_textures = std::min(limits.maxDescriptorSetUpdateAfterBindSampledImages, limits.maxPerStageDescriptorUpdateAfterBindSampledImages);
+	auto const max_samplers = std::min(limits.maxDescriptorSetUpdateAfterBindSamplers, limits.maxPerStageDescriptorUpdateAfterBindSamplers);
+	if (create_info.max_textures > max_textures || create_info.max_samplers > max_samplers) {
+		log.warn("BindlessTable: capacity clamped to {} textures, {} samplers", max_textures, max_samplers);
+	}
+	create_info.max_textures = std::clamp(create_info.max_textures, 1u, max_textures);
+	create_info.max_samplers = std::clamp(create_info.max_samplers, 1u, max_samplers);
+	return create_info;
+}
+} // namespace
+
+BindlessTable::BindlessTable(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info)
+	: m_render_device(render_device), m_texture_slots(0), m_sampler_slots(0), m_release_cursor(get_vma(*render_device).get_release_cursor()) {
+	auto const capacities = clamp_capacities(m_render_device->get_gpu().device, create_info);
+	m_texture_slots = Slots{capacities.max_textures};
+	m_sampler_slots = Slots{capacities.max_samplers};
+	auto const device = m_render_device->get_device();
+
+	// unregistered / removed elements are never written (or left stale): they must not be accessed by shaders.
+	static constexpr auto binding_flags_v = vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+											vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+	auto const bindings = std::array{
+		vk::DescriptorSetLayoutBinding{texture_binding_v, vk::DescriptorType::eSampledImage, capacities.max_textures, vk::ShaderStageFlagBits::eAll},
+		vk::DescriptorSetLayoutBinding{sampler_binding_v, vk::DescriptorType::eSampler, capacities.max_samplers, vk::ShaderStageFlagBits::eAll},
+	};
+	auto const binding_flags = std::array{vk::DescriptorBindingFlags{binding_flags_v}, vk::DescriptorBindingFlags{binding_flags_v}};
+	auto const dslbfci = vk::DescriptorSetLayoutBindingFlagsCreateInfo{binding_flags};
+	auto dslci = vk::DescriptorSetLayoutCreateInfo{};
+	dslci.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool).setBindings(bindings).setPNext(&dslbfci);
+	m_set_layout = device.createDescriptorSetLayoutUnique(dslci);
+
+	static constexpr auto sets_v = std::uint32_t(resource_buffering_v);
+	auto const pool_sizes = std::array{
+		vk::DescriptorPoolSize{vk::DescriptorType::eSampledImage, capacities.max_textures * sets_v},
+		vk::DescriptorPoolSize{vk::DescriptorType::eSampler, capacities.max_samplers * sets_v},
+	};
+	auto dpci = vk::DescriptorPoolCreateInfo{};
+	dpci.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind).setPoolSizes(pool_sizes).setMaxSets(sets_v);
+	m_pool = device.createDescriptorPoolUnique(dpci);
+
+	auto set_layouts = Ring<vk::DescriptorSetLayout>{};
+	set_layouts.fill(*m_set_layout);
+	auto dsai = vk::DescriptorSetAllocateInfo{};
+	dsai.setDescriptorPool(*m_pool).setSetLayouts(set_layouts);
+	if (device.allocateDescriptorSets(&dsai, m_sets.data()) != vk::Result::eSuccess) { throw Panic{"Failed to allocate Bindless Descriptor Sets"}; }
+
+	m_textures.resize(capacities.max_textures);
+	m_samplers.resize(capacities.max_samplers);
+	log.debug("BindlessTable: {} textures, {} samplers", capacities.max_textures, capacities.max_samplers);
+}
+
+auto BindlessTable::add_texture(IRenderImage const& image) -> std::optional<TextureIndex> {
+	auto lock = std::scoped_lock{m_mutex};
+	auto const index = m_texture_slots.acquire();
+	if (!index) { return {}; }
+	m_textures.at(*index).image = &image;
+	set_view(*index, image.get_image_view());
+	// recycled indices are not used by any pending frame: all sets can be written.
+	for (auto const set : m_sets) { write_texture(set, *index, image.get_image_view()); }
+	return TextureIndex{*index};
+}
+
+void BindlessTable::remove_texture(TextureIndex const index) {
+	auto lock = std::scoped_lock{m_mutex};
+	auto& texture = m_textures.at(std::size_t(index));
+	if (texture.image == nullptr) { return; }
+	auto const [first, last] = m_slots_by_view.equal_range(vma::to_word(texture.view));
+	auto const it = std::find_if(first, last, [index](auto const& pair) { return pair.second == std::uint32_t(index); });
+	if (it != last) { m_slots_by_view.erase(it); }
+	texture = {};
+	m_texture_slots.release(std::uint32_t(index), m_frame_count);
+}
+
+auto BindlessTable::add_sampler(vk::Sampler const sampler) -> std::optional<SamplerIndex> {
+	auto lock = std::scoped_lock{m_mutex};
+	auto const index = m_sampler_slots.acquire();
+	if (!index) { return {}; }
+	m_samplers.at(*index) = sampler;
+	for (auto const set : m_sets) { write_sampler(set, *index, sampler); }
+	return SamplerIndex{*index};
+}
+
+void BindlessTable::remove_sampler(SamplerIndex const index) {
+	auto lock = std::scoped_lock{m_mutex};
+	auto& sampler = m_samplers.at(std::size_t(index));
+	if (!sampler) { return; }
+	sampler = vk::Sampler{};
+	m_sampler_slots.release(std::uint32_t(index), m_frame_count);
+}
+
+auto BindlessTable::get_stats() const -> BindlessTableStats {
+	auto lock = std::scoped_lock{m_mutex};
+	return BindlessTableStats{
+		.textures = m_texture_slots.get_used(),
+		.max_textures = m_texture_slots.get_capacity(),
+		.samplers = m_sampler_slots.get_used(),
+		.max_samplers = m_sampler_slots.get_capacity(),
+	};
+}
+
+void BindlessTable::refresh() {
+	auto lock = std::scoped_lock{m_mutex};
+	m_released.clear();
+	m_dirty.clear();
+	if (get_vma(*m_render_device).get_releases(m_release_cursor, m_released)) {
+		// images that were resized / recreated / relocated have released their previous views.
+		for (auto const handle : m_released) {
+			auto const [first, last] = m_slots_by_view.equal_range(handle);
+			for (auto it = first; it != last; ++it) { m_dirty.push_back(it->second); }
+			m_slots_by_view.erase(first, last);
+		}
+	} else {
+		m_slots_by_view.clear();
+		for (std::uint32_t index = 0; index < m_textures.size(); ++index) {
+			if (m_textures.at(index).image != nullptr) { m_dirty.push_back(index); }
+		}
+	}
+
+	// a recycled handle may equal the previous one: rewrite regardless.
+	for (auto const index : m_dirty) { set_view(index, m_textures.at(index).image->get_image_view()); }
+	for (auto& pending : m_pending) { pending.insert(pending.end(), m_dirty.begin(), m_dirty.end()); }
+
+	// the current frame's fence has been waited on: its set is not in use by the device.
+	auto const frame_index = std::size_t(m_render_device->get_frame_index());
+	auto& pending = m_pending.at(frame_index);
+	for (auto const index : pending) {
+		// removed since it was queued.
+		auto const& texture = m_textures.at(index);
+		if (texture.image != nullptr) { write_texture(m_sets.at(frame_index), index, texture.view); }
+	}
+	pending.clear();
+}
+
+void BindlessTable::on_next_frame(FrameIndex /*frame_index*/) {
+	auto lock = std::scoped_lock{m_mutex};
+	++m_frame_count;
+	m_texture_slots.recycle(m_frame_count);
+	m_sampler_slots.recycle(m_frame_count);
+}
+
+auto BindlessTable::get_set() const -> vk::DescriptorSet { return m_sets.at(std::size_t(m_render_device->get_frame_index())); }
+
+void BindlessTable::set_view(std::uint32_t const index, vk::ImageView const view) {
+	m_textures.at(index).view = view;
+	m_slots_by_view.emplace(vma::to_word(view), index);
+}
+
+void BindlessTable::write_texture(vk::DescriptorSet const set, std::uint32_t const index, vk::ImageView const view) const {
+	auto const dii = vk::DescriptorImageInfo{{}, view, vk::ImageLayout::eShaderReadOnlyOptimal};
+	auto wds = vk::WriteDescriptorSet{};
+	wds.setDstSet(set).setDstBinding(texture_binding_v).setDstArrayElement(index).setDescriptorType(vk::DescriptorType::eSampledImage).setImageInfo(dii);
+	m_render_device->get_device().updateDescriptorSets(wds, {});
+}
+
+void BindlessTable::write_sampler(vk::DescriptorSet const set, std::uint32_t const index, vk::Sampler const sampler) const {
+	auto const dii = vk::DescriptorImageInfo{sampler};
+	auto wds = vk::WriteDescriptorSet{};
+	wds.setDstSet(set).setDstBinding(sampler_binding_v).setDstArrayElement(index).setDescriptorType(vk::DescriptorType::eSampler).setImageInfo(dii);
+	m_render_device->get_device().updateDescriptorSets(wds, {});
+}
+
+auto BindlessTable::Slots::acquire() -> std::optional<std::uint32_t> {
+	if (!m_free.empty()) {
+		auto const ret = m_free.back();
+		m_free.pop_back();
+		return ret;
+	}
+	if (m_next >= m_capacity) { return {}; }
+	return m_next++;
+}
+
+void BindlessTable::Slots::recycle(std::uint64_t const frame) {
+	// a frame that could have used the index has completed once its FrameIndex comes around again.
+	while (!m_retiring.empty() && m_retiring.front().frame + resource_buffering_v <= frame) {
+		m_free.push_back(m_retiring.front().index);
+		m_retiring.pop_front();
+	}
+}
+} // namespace detail
+
+void IBindlessTable::bind(vk::CommandBuffer const command_buffer, vk::PipelineLayout const pipeline_layout, std::uint32_t const set,
+						  vk::PipelineBindPoint const bind_point) const {
+	command_buffer.bindDescriptorSets(bind_point, pipeline_layout, set, get_set(), {});
+}
+} // namespace kvf
@@ -0,0 +1,91 @@
+#pragma once
+#include "kvf/bindless_table.hpp"
+#include "kvf/next_frame_listener.hpp"
+#include "kvf/ring.hpp"
+#include <gsl/pointers>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace kvf::detail {
+class BindlessTable : public IBindlessTable, public INextFrameListener {
+  public:
+	explicit BindlessTable(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info);
+
+	[[nodiscard]] auto get_set_layout() const -> vk::DescriptorSetLayout final { return *m_set_layout; }
+	[[nodiscard]] auto get_set() const -> vk::DescriptorSet final;
+
+	[[nodiscard]] auto add_texture(IRenderImage const& image) -> std::optional<TextureIndex> final;
+	void remove_texture(TextureIndex index) final;
+
+	[[nodiscard]] auto add_sampler(vk::Sampler sampler) -> std::optional<SamplerIndex> final;
+	void remove_sampler(SamplerIndex index) final;
+
+	[[nodiscard]] auto get_stats() const -> BindlessTableStats final;
+
+	/// \brief Rewrite slots whose views have been replaced or destroyed since the last call.
+	/// Only the current frame's set is written: other sets are written when their frames come around.
+	void refresh();
+
+  private:
+	// array indices: removed indices are recycled after resource_buffering_v frames.
+	class Slots {
+	  public:
+		explicit Slots(std::uint32_t capacity) : m_capacity(capacity) {}
+
+		[[nodiscard]] auto acquire() -> std::optional<std::uint32_t>;
+		void release(std::uint32_t index, std::uint64_t frame) { m_retiring.push_back(Retiring{.index = index, .frame = frame}); }
+		void recycle(std::uint64_t frame);
+
+		[[nodiscard]] auto get_capacity() const -> std::uint32_t { return m_capacity; }
+		[[nodiscard]] auto get_used() const -> std::uint32_t { return m_next - std::uint32_t(m_free.size() + m_retiring.size()); }
+
+	  private:
+		struct Retiring {
+			std::uint32_t index{};
+			std::uint64_t frame{};
+		};
+
+		std::uint32_t m_capacity{};
+		std::uint32_t m_next{};
+		std::vector<std::uint32_t> m_free{};
+		std::deque<Retiring> m_retiring{};
+	};
+
+	struct Texture {
+		IRenderImage const* image{};
+		vk::ImageView view{};
+	};
+
+	void on_next_frame(FrameIndex frame_index) final;
+
+	void set_view(std::uint32_t index, vk::ImageView view);
+	void write_texture(vk::DescriptorSet set, std::uint32_t index, vk::ImageView view) const;
+	void write_sampler(vk::DescriptorSet set, std::uint32_t index, vk::Sampler sampler) const;
+
+	gsl::not_null<IRenderDevice*> m_render_device;
+
+	vk::UniqueDescriptorSetLayout m_set_layout{};
+	vk::UniqueDescriptorPool m_pool{};
+	// one set per FrameIndex: a set may only be written once its frame's fence has been waited on.
+	Ring<vk::DescriptorSet> m_sets{};
+	// slots whose views changed since each set was last written.
+	Ring<std::vector<std::uint32_t>> m_pending{};
+
+	Slots m_texture_slots;
+	Slots m_sampler_slots;
+	std::vector<Texture> m_textures{};
+	// registered samplers (null for free / retiring slots).
+	std::vector<vk::Sampler> m_samplers{};
+	// registered views: an image may be registered more than once.
+	std::unordered_multimap<std::uint64_t, std::uint32_t> m_slots_by_view{};
+	std::uint64_t m_release_cursor{};
+	std::vector<std::uint64_t> m_released{};
+	std::vector<std::uint32_t> m_dirty{};
+	std::uint64_t m_frame_count{};
+
+	mutable std::mutex m_mutex{};
+};
+} // namespace kvf::detail
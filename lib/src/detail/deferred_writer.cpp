@@ -0,0 +1,167 @@
+#include "detail/deferred_writer.hpp"
+#include "detail/vma.hpp"
+#include "klib/debug/assert.hpp"
+#include "kvf/render_device.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <span>
+
+namespace kvf::detail {
+namespace {
+void record_memory_barrier(vk::CommandBuffer const command_buffer, vk::MemoryBarrier2 const& barrier) {
+	auto di = vk::DependencyInfo{};
+	di.setMemoryBarriers(barrier);
+	command_buffer.pipelineBarrier2(di);
+}
+} // namespace
+
+DeferredWriter::DeferredWriter(gsl::not_null<IRenderDevice*> render_device)
+	: m_render_device(render_device), m_release_cursor(get_vma(*render_device).get_release_cursor()) {}
+
+void DeferredWriter::enqueue(vk::Buffer const dst, std::span<BufferWrite const> writes, vk::DeviceSize offset) {
+	auto lock = std::scoped_lock{m_mutex};
+	// dst may reuse the handle of a released buffer: drop writes to that one first.
+	drop_released();
+	for (auto const write : writes) {
+		if (write.is_empty()) { continue; }
+		auto const src_offset = m_bytes.size();
+		m_bytes.resize(src_offset + write.size());
+		std::memcpy(m_bytes.data() + src_offset, write.data(), write.size());
+		// extend the previous write if both source and destination ranges are contiguous with it (and it hasn't been recorded yet).
+		if (m_pending.size() > m_recorded) {
+			auto& last = m_pending.back();
+			if (last.dst == dst && last.dst_offset + last.size == offset && last.src_offset + last.size == src_offset) {
+				last.size += write.size();
+				offset += write.size();
+				continue;
+			}
+		}
+		m_pending.push_back(Write{.dst = dst, .dst_offset = offset, .src_offset = src_offset, .size = write.size()});
+		offset += write.size();
+	}
+}
+
+void DeferredWriter::record(vk::CommandBuffer const command_buffer, FrameIndex const frame_index) {
+	auto lock = std::scoped_lock{m_mutex};
+	m_retired.at(std::size_t(frame_index)).clear();
+	// writes recorded into a command buffer that was never submitted are recorded again.
+	m_recorded = 0;
+	drop_released();
+	record_from(0, command_buffer, frame_index);
+}
+
+void DeferredWriter::flush(vk::CommandBuffer const command_buffer, FrameIndex const frame_index) {
+	auto lock = std::scoped_lock{m_mutex};
+	drop_released();
+	record_from(m_recorded, command_buffer, frame_index);
+}
+
+// handles of released buffers are stale, and may be recycled: drop pending writes to them (those already recorded are in flight).
+void DeferredWriter::drop_released() {
+	auto const first = m_pending.begin() + std::ptrdiff_t(m_recorded);
+	m_released.clear();
+	if (!get_vma(*m_render_device).get_releases(m_release_cursor, m_released)) {
+		if (first != m_pending.end()) { log.warn("DeferredWriter: release log overflowed, dropping {} pending writes", m_pending.end() - first); }
+		m_pending.erase(first, m_pending.end());
+	} else if (!m_released.empty()) {
+		auto const is_released = [this](Write const& write) { return std::ranges::find(m_released, vma::to_word(write.dst)) != m_released.end(); };
+		m_pending.erase(std::remove_if(first, m_pending.end(), is_released), m_pending.end());
+	}
+	// bytes of dropped writes are erased along with those of recorded writes once submitted.
+	if (m_pending.empty()) { m_bytes.clear(); }
+}
+
+void DeferredWriter::record_from(std::size_t const first, vk::CommandBuffer const command_buffer, FrameIndex const frame_index) {
+	m_recorded = m_pending.size();
+	if (first >= m_pending.size()) { return; }
+
+	// staging mirrors m_bytes: bytes of writes already recorded this frame are left untouched.
+	auto const pending = std::span{m_pending}.subspan(first);
+	auto const begin = pending.front().src_offset;
+	auto& staging = get_staging(frame_index, m_bytes.size(), first > 0);
+	std::memcpy(static_cast<std::byte*>(staging.get_mapped_ptr()) + begin, m_bytes.data() + begin, m_bytes.size() - begin);
+
+	// targets may still be in use by previously submitted frames.
+	auto barrier = vk::MemoryBarrier2{};
+	barrier.setSrcAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+		.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+		.setDstAccessMask(vk::AccessFlagBits2::eTransferWrite)
+		.setDstStageMask(vk::PipelineStageFlagBits2::eTransfer);
+	record_memory_barrier(command_buffer, barrier);
+
+	// consecutive writes to the same buffer are batched into one copy, unless they overlap an earlier write:
+	// copies to overlapping ranges are unordered without a barrier between them.
+	auto regions = std::vector<vk::BufferCopy2>{};
+	auto written = std::vector<Write const*>{};
+	auto dst = vk::Buffer{};
+	auto const flush = [&] {
+		if (regions.empty()) { return; }
+		auto cbi = vk::CopyBufferInfo2{};
+		cbi.setSrcBuffer(staging.get_buffer()).setDstBuffer(dst).setRegions(regions);
+		command_buffer.copyBuffer2(cbi);
+		regions.clear();
+	};
+	for (auto const& write : pending) {
+		auto const overlaps = std::ranges::any_of(written, [&write](Write const* w) {
+			return w->dst == write.dst && w->dst_offset < write.dst_offset + write.size && write.dst_offset < w->dst_offset + w->size;
+		});
+		if (write.dst != dst || overlaps) { flush(); }
+		if (overlaps) {
+			barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite).setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer);
+			record_memory_barrier(command_buffer, barrier);
+			written.clear();
+		}
+		dst = write.dst;
+		regions.emplace_back(write.src_offset, write.dst_offset, write.size);
+		written.push_back(&write);
+	}
+	flush();
+
+	barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+		.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
+		.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+		.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+	record_memory_barrier(command_buffer, barrier);
+}
+
+void DeferredWriter::on_submitted() {
+	auto lock = std::scoped_lock{m_mutex};
+	if (m_recorded == 0) { return; }
+
+	KLIB_ASSERT(m_recorded <= m_pending.size());
+	auto const& last = m_pending.at(m_recorded - 1);
+	auto const recorded_bytes = last.src_offset + last.size;
+	m_pending.erase(m_pending.begin(), m_pending.begin() + std::ptrdiff_t(m_recorded));
+	m_bytes.erase(m_bytes.begin(), m_bytes.begin() + std::ptrdiff_t(recorded_bytes));
+	for (auto& write : m_pending) { write.src_offset -= recorded_bytes; }
+	m_recorded = 0;
+}
+
+void DeferredWriter::retarget(vk::Buffer const from, vk::Buffer const to) {
+	auto lock = std::scoped_lock{m_mutex};
+	for (auto& write : m_pending) {
+		if (write.dst == from) { write.dst = to; }
+	}
+}
+
+auto DeferredWriter::get_staging(FrameIndex const frame_index, vk::DeviceSize const size, bool const in_use) -> IRenderBuffer& {
+	auto& ret = m_staging.at(std::size_t(frame_index));
+	auto const capacity = std::max(std::bit_ceil(size), min_staging_size_v);
+	// copies recorded earlier in this frame read from the current buffer: keep it alive until the frame's fence is next waited on.
+	if (ret && in_use && ret->get_capacity() < size) { m_retired.at(std::size_t(frame_index)).push_back(std::move(ret)); }
+	if (!ret) {
+		auto const bci = BufferCreateInfo{
+			.usage = vk::BufferUsageFlagBits::eTransferSrc,
+			.type = BufferType::Host,
+			.size = capacity,
+			.category = MemoryCategory::RingBuffer,
+		};
+		ret = IRenderBuffer::create(m_render_device, bci);
+	} else if (ret->get_capacity() < size) {
+		ret->resize(capacity);
+	}
+	return *ret;
+}
+} // namespace kvf::detail
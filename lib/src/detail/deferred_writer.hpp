@@ -0,0 +1,60 @@
+#pragma once
+#include "kvf/buffer_write.hpp"
+#include "kvf/frame_index.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include "kvf/render_buffer.hpp"
+#include "kvf/ring.hpp"
+#include <gsl/pointers>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace kvf::detail {
+/// \brief Buffer writes staged on the host and copied at the start of the next frame's command buffer, or at an explicit flush.
+/// Writes remain pending until the frame that recorded them is submitted; pending writes to buffers released before they are recorded are dropped.
+class DeferredWriter {
+  public:
+	static constexpr vk::DeviceSize min_staging_size_v{64 * 1024};
+
+	explicit DeferredWriter(gsl::not_null<IRenderDevice*> render_device);
+
+	void enqueue(vk::Buffer dst, std::span<BufferWrite const> writes, vk::DeviceSize offset);
+
+	/// \brief Copy pending writes into this frame's staging buffer and record transfers into command_buffer.
+	/// Fence for frame_index must have been waited on.
+	void record(vk::CommandBuffer command_buffer, FrameIndex frame_index);
+	/// \brief Record transfers for writes enqueued since the last record / flush into command_buffer (the current frame's).
+	/// Must be called outside a rendering scope.
+	void flush(vk::CommandBuffer command_buffer, FrameIndex frame_index);
+	/// \brief Drop writes recorded into the submitted command buffer.
+	void on_submitted();
+	/// \brief Redirect pending writes to a buffer whose handle was replaced (by defragmentation).
+	void retarget(vk::Buffer from, vk::Buffer to);
+
+  private:
+	struct Write {
+		vk::Buffer dst{};
+		vk::DeviceSize dst_offset{};
+		vk::DeviceSize src_offset{};
+		vk::DeviceSize size{};
+	};
+
+	void drop_released();
+	void record_from(std::size_t first, vk::CommandBuffer command_buffer, FrameIndex frame_index);
+	[[nodiscard]] auto get_staging(FrameIndex frame_index, vk::DeviceSize size, bool in_use) -> IRenderBuffer&;
+
+	gsl::not_null<IRenderDevice*> m_render_device;
+
+	Ring<std::unique_ptr<IRenderBuffer>> m_staging{};
+	// staging buffers outgrown by a flush, while still referenced by the frame's command buffer.
+	Ring<std::vector<std::unique_ptr<IRenderBuffer>>> m_retired{};
+	std::vector<std::byte> m_bytes{};
+	std::vector<Write> m_pending{};
+	std::size_t m_recorded{};
+	std::uint64_t m_release_cursor{};
+	std::vector<std::uint64_t> m_released{};
+
+	std::mutex m_mutex{};
+};
+} // namespace kvf::detail
@@ -0,0 +1,147 @@
+#include "detail/defragmenter.hpp"
+#include "detail/deferred_writer.hpp"
+#include "klib/debug/assert.hpp"
+#include "kvf/panic.hpp"
+#include "kvf/upload_queue.hpp"
+#include "log.hpp"
+#include <span>
+
+namespace kvf::detail {
+namespace {
+void record_memory_barrier(vk::CommandBuffer const command_buffer, vk::MemoryBarrier2 const& barrier) {
+	auto di = vk::DependencyInfo{};
+	di.setMemoryBarriers(barrier);
+	command_buffer.pipelineBarrier2(di);
+}
+
+[[nodiscard]] auto create_timeline(vk::Device const device) -> vk::UniqueSemaphore {
+	auto stci = vk::SemaphoreTypeCreateInfo{};
+	stci.setSemaphoreType(vk::SemaphoreType::eTimeline).setInitialValue(0);
+	auto sci = vk::SemaphoreCreateInfo{};
+	sci.setPNext(&stci);
+	return device.createSemaphoreUnique(sci);
+}
+} // namespace
+
+Defragmenter::Defragmenter(gsl::not_null<IRenderDevice*> render_device, DefragPolicy const& policy) : m_render_device(render_device), m_policy(policy) {
+	auto const device = m_render_device->get_device();
+	auto cpci = vk::CommandPoolCreateInfo{};
+	cpci.setQueueFamilyIndex(m_render_device->get_queue_family()).setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
+	m_command_pool = device.createCommandPoolUnique(cpci);
+	auto cbai = vk::CommandBufferAllocateInfo{};
+	cbai.setCommandPool(*m_command_pool).setCommandBufferCount(1);
+	if (device.allocateCommandBuffers(&cbai, &m_command_buffer) != vk::Result::eSuccess) { throw Panic{"Failed to allocate Vulkan Command Buffer"}; }
+	m_timeline = create_timeline(device);
+}
+
+Defragmenter::~Defragmenter() {
+	// the device is idle by now.
+	if (m_pass) { end_pass(); }
+	if (m_context == nullptr) { return; }
+	vmaEndDefragmentation(m_render_device->get_allocator(), m_context, nullptr);
+}
+
+void Defragmenter::update(DeferredWriter& deferred_writer) {
+	++m_frame;
+	if (m_pass) {
+		if (m_render_device->get_device().getSemaphoreCounterValue(*m_timeline) < m_pass->value) { return; }
+		end_pass();
+	}
+	if (m_context == nullptr && (!should_start() || !begin_run())) { return; }
+
+	// moves must not race uploads into the same resources (possibly on a dedicated transfer queue): retry next frame.
+	auto& upload_queue = m_render_device->get_upload_queue();
+	if (!upload_queue.is_ready(upload_queue.flush())) { return; }
+
+	begin_pass(deferred_writer);
+}
+
+auto Defragmenter::should_start() const -> bool {
+	if (m_requested) { return true; }
+	return m_policy.interval_frames > 0 && m_frame >= m_last_run + m_policy.interval_frames;
+}
+
+auto Defragmenter::begin_run() -> bool {
+	m_requested = false;
+	m_last_run = m_frame;
+
+	auto vdi = VmaDefragmentationInfo{};
+	vdi.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_FAST_BIT;
+	vdi.maxBytesPerPass = m_policy.max_bytes_per_pass;
+	vdi.maxAllocationsPerPass = m_policy.max_moves_per_pass;
+	if (vmaBeginDefragmentation(m_render_device->get_allocator(), &vdi, &m_context) != VK_SUCCESS) {
+		log.warn("Failed to begin defragmentation");
+		m_context = nullptr;
+		return false;
+	}
+	return true;
+}
+
+void Defragmenter::begin_pass(DeferredWriter& deferred_writer) {
+	auto pass = Pass{};
+	if (vmaBeginDefragmentationPass(m_render_device->get_allocator(), m_context, &pass.info) == VK_SUCCESS) {
+		end_run();
+		return;
+	}
+
+	// the previous pass has completed, its command buffer is no longer in use.
+	m_command_buffer.begin(vk::CommandBufferBeginInfo{vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+	auto const moves = std::span{pass.info.pMoves, pass.info.moveCount};
+	pass.retired.reserve(moves.size());
+	auto barrier = vk::MemoryBarrier2{};
+	barrier.setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+		.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+		.setDstAccessMask(vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite)
+		.setDstStageMask(vk::PipelineStageFlagBits2::eTransfer);
+	record_memory_barrier(m_command_buffer, barrier);
+	get_vma(*m_render_device).begin_moves(m_command_buffer, moves, pass.retired);
+	// the second scope covers everything submitted to the queue later: immediate writes, reads, uploads and frames using the new handles.
+	barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+		.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
+		.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+		.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+	record_memory_barrier(m_command_buffer, barrier);
+	m_command_buffer.end();
+
+	for (auto const& r : pass.retired) {
+		if (r.buffer) { deferred_writer.retarget(*r.buffer, r.new_buffer); }
+	}
+
+	m_pass = std::move(pass);
+	// nothing was recorded that the pass has to wait for.
+	if (m_pass->retired.empty()) {
+		end_pass();
+		return;
+	}
+
+	// handles have already been replaced: submit now, ahead of any other work that could use them.
+	m_pass->value = ++m_value;
+	auto const cbsi = vk::CommandBufferSubmitInfo{m_command_buffer};
+	auto const sssi = vk::SemaphoreSubmitInfo{*m_timeline, m_value, vk::PipelineStageFlagBits2::eAllCommands};
+	auto si = vk::SubmitInfo2{};
+	si.setCommandBufferInfos(cbsi).setSignalSemaphoreInfos(sssi);
+	m_render_device->queue_submit(si);
+}
+
+void Defragmenter::end_pass() {
+	KLIB_ASSERT(m_pass);
+	auto pass = std::move(*m_pass);
+	m_pass.reset();
+
+	// the copies have completed, and so has every earlier submission (first scope of the barrier recorded before them).
+	auto const moved = pass.retired.size();
+	pass.retired.clear();
+	get_vma(*m_render_device).end_moves(std::span{pass.info.pMoves, pass.info.moveCount});
+
+	// stop early if nothing in this pass could be moved, to avoid repeating the same ignored moves.
+	if (vmaEndDefragmentationPass(m_render_device->get_allocator(), m_context, &pass.info) == VK_SUCCESS || moved == 0) { end_run(); }
+}
+
+void Defragmenter::end_run() {
+	auto stats = VmaDefragmentationStats{};
+	vmaEndDefragmentation(m_render_device->get_allocator(), m_context, &stats);
+	m_context = nullptr;
+	if (stats.allocationsMoved == 0) { return; }
+	log.debug("Defragmentation: {} allocations moved ({} bytes), {} bytes freed", stats.allocationsMoved, stats.bytesMoved, stats.bytesFreed);
+}
+} // namespace kvf::detail
@@ -0,0 +1,66 @@
+#pragma once
+#include "detail/vma.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include "kvf/render_device.hpp"
+#include <gsl/pointers>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace kvf::detail {
+class DeferredWriter;
+
+/// \brief Incremental defragmentation of the default VMA pools: at most one bounded pass in flight.
+/// Moves are submitted on their own at the start of a frame, ahead of any other work that could touch the moved resources;
+/// moved resources get new vk::Buffer / vk::Image / vk::ImageView handles, old handles and source memory are released once the copies complete.
+class Defragmenter {
+  public:
+	explicit Defragmenter(gsl::not_null<IRenderDevice*> render_device, DefragPolicy const& policy);
+
+	Defragmenter(Defragmenter const&) = delete;
+	Defragmenter(Defragmenter&&) = delete;
+	auto operator=(Defragmenter const&) -> Defragmenter& = delete;
+	auto operator=(Defragmenter&&) -> Defragmenter& = delete;
+
+	~Defragmenter();
+
+	/// \brief Start a run at the next update, regardless of the policy interval.
+	void request() { m_requested = true; }
+
+	/// \brief End the pass in flight if its copies have completed, and submit the next one if due.
+	/// Must be called at the start of a frame, before any of its commands are recorded.
+	void update(DeferredWriter& deferred_writer);
+
+	/// \brief Timeline semaphore signaled with the value of each pass once its copies complete.
+	/// Work on other queues touching movable resources must wait for get_value().
+	[[nodiscard]] auto get_timeline() const -> vk::Semaphore { return *m_timeline; }
+	[[nodiscard]] auto get_value() const -> std::uint64_t { return m_value; }
+
+  private:
+	struct Pass {
+		VmaDefragmentationPassMoveInfo info{};
+		std::vector<vma::Retired> retired{};
+		std::uint64_t value{};
+	};
+
+	[[nodiscard]] auto should_start() const -> bool;
+	[[nodiscard]] auto begin_run() -> bool;
+	void begin_pass(DeferredWriter& deferred_writer);
+	void end_pass();
+	void end_run();
+
+	gsl::not_null<IRenderDevice*> m_render_device;
+	DefragPolicy m_policy{};
+
+	vk::UniqueCommandPool m_command_pool{};
+	vk::CommandBuffer m_command_buffer{};
+	vk::UniqueSemaphore m_timeline{};
+	std::uint64_t m_value{};
+
+	VmaDefragmentationContext m_context{};
+	std::optional<Pass> m_pass{};
+	std::uint64_t m_frame{};
+	std::uint64_t m_last_run{};
+	bool m_requested{};
+};
+} // namespace kvf::detail
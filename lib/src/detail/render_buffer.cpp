@@ -3,7 +3,9 @@
 #include "kvf/render_device.hpp"
 #include "kvf/scratch_command_buffer.hpp"
 #include "kvf/util.hpp"
+#include <algorithm>
 #include <numeric>
+#include <vector>
 
 namespace kvf {
 namespace detail {
@@ -11,6 +13,19 @@ RenderBuffer::RenderBuffer(gsl::not_null<IRenderDevice*> render_device, CreateIn
 	recreate_impl(create_info);
 }
 
+void RenderBuffer::set_movable() {
+	m_movable = true;
+	m_buffer.get().allocator->set_movable(m_buffer.get().allocation, this);
+}
+
+auto RenderBuffer::get_device_address() const -> vk::DeviceAddress {
+	if (m_movable && !m_address_pinned) {
+		m_address_pinned = true;
+		m_buffer.get().allocator->set_movable(m_buffer.get().allocation, nullptr);
+	}
+	return m_buffer.get().device_address;
+}
+
 void RenderBuffer::resize(vk::DeviceSize size) {
 	util::ensure_positive(size);
 
@@ -24,8 +39,9 @@ void RenderBuffer::resize(vk::DeviceSize size) {
 	recreate_impl(info);
 }
 
-auto RenderBuffer::write_contiguous(std::span<BufferWrite const> writes, vk::DeviceSize const write_size, vk::DeviceSize const offset) -> bool {
-	if (get_size() < offset + write_size) { return false; }
+auto RenderBuffer::write_contiguous(std::span<BufferWrite const> writes, vk::DeviceSize const write_size, vk::DeviceSize const offset,
+								   BufferWriteMode const mode) -> bool {
+	if (offset > get_size() || write_size > get_size() - offset) { return false; }
 	if (write_size == 0) { return true; }
 
 	if (auto dst = get_mapped_span(); !dst.empty()) {
@@ -41,13 +57,18 @@ auto RenderBuffer::write_contiguous(std::span<BufferWrite const> writes, vk::Dev
 
 	if ((m_info.usage & vk::BufferUsageFlagBits::eTransferDst) != vk::BufferUsageFlagBits::eTransferDst) { return false; }
 
+	if (mode == BufferWriteMode::Deferred) {
+		m_render_device->defer_write(get_buffer(), writes, offset);
+		return true;
+	}
+
 	auto const bci = BufferCreateInfo{
 		.usage = vk::BufferUsageFlagBits::eTransferSrc,
 		.type = BufferType::Host,
 		.size = write_size,
 	};
 	auto staging = RenderBuffer{m_render_device, bci};
-	if (!staging.write_contiguous(writes, write_size, 0)) { return false; }
+	if (!staging.write_contiguous(writes, write_size, 0, BufferWriteMode::Immediate)) { return false; }
 
 	auto const bc = vk::BufferCopy2{0, offset, staging.get_size()};
 	auto cbi = vk::CopyBufferInfo2{};
@@ -58,26 +79,109 @@ auto RenderBuffer::write_contiguous(std::span<BufferWrite const> writes, vk::Dev
 	return cmd.submit_and_wait();
 }
 
+auto RenderBuffer::write_scattered(std::span<ScatterWrite const> writes, BufferWriteMode const mode) -> bool {
+	auto sorted = std::vector<ScatterWrite>{};
+	sorted.reserve(writes.size());
+	for (auto const& write : writes) {
+		if (!write.write.is_empty()) { sorted.push_back(write); }
+	}
+	std::ranges::stable_sort(sorted, {}, &ScatterWrite::offset);
+	for (std::size_t i = 0; i < sorted.size(); ++i) {
+		auto const& write = sorted[i];
+		if (write.offset > get_size() || write.write.size() > get_size() - write.offset) { return false; }
+		if (i > 0 && sorted[i - 1].offset + sorted[i - 1].write.size() > write.offset) { return false; }
+	}
+	if (sorted.empty()) { return true; }
+
+	if (auto const dst = get_mapped_span(); !dst.empty()) {
+		for (auto const& write : sorted) { std::memcpy(dst.subspan(write.offset).data(), write.write.data(), write.write.size()); }
+		return true;
+	}
+
+	if ((m_info.usage & vk::BufferUsageFlagBits::eTransferDst) != vk::BufferUsageFlagBits::eTransferDst) { return false; }
+
+	// coalesce adjacent writes into runs: each run is staged contiguously.
+	struct Run {
+		vk::DeviceSize offset{};
+		vk::DeviceSize size{};
+		std::size_t first{};
+		std::size_t count{};
+	};
+	auto runs = std::vector<Run>{};
+	auto buffer_writes = std::vector<BufferWrite>{};
+	buffer_writes.reserve(sorted.size());
+	for (auto const& write : sorted) {
+		if (runs.empty() || runs.back().offset + runs.back().size != write.offset) {
+			runs.push_back(Run{.offset = write.offset, .first = buffer_writes.size()});
+		}
+		runs.back().size += write.write.size();
+		++runs.back().count;
+		buffer_writes.push_back(write.write);
+	}
+
+	if (mode == BufferWriteMode::Deferred) {
+		for (auto const& run : runs) { m_render_device->defer_write(get_buffer(), std::span{buffer_writes}.subspan(run.first, run.count), run.offset); }
+		return true;
+	}
+
+	auto regions = std::vector<vk::BufferCopy2>{};
+	regions.reserve(runs.size());
+	auto staged_size = vk::DeviceSize{};
+	for (auto const& run : runs) {
+		regions.emplace_back(staged_size, run.offset, run.size);
+		staged_size += run.size;
+	}
+
+	auto const bci = BufferCreateInfo{
+		.usage = vk::BufferUsageFlagBits::eTransferSrc,
+		.type = BufferType::Host,
+		.size = staged_size,
+	};
+	auto staging = RenderBuffer{m_render_device, bci};
+	if (!staging.write_contiguous(buffer_writes, staged_size, 0, BufferWriteMode::Immediate)) { return false; }
+
+	auto cbi = vk::CopyBufferInfo2{};
+	cbi.setSrcBuffer(staging.get_buffer()).setDstBuffer(get_buffer()).setRegions(regions);
+
+	auto cmd = ScratchCommandBuffer{m_render_device};
+	cmd.get().copyBuffer2(cbi);
+	return cmd.submit_and_wait();
+}
+
+auto RenderBuffer::move_to(vk::CommandBuffer const command_buffer, VmaAllocation dst, vma::Retired& retired) -> bool {
+	// host pointers into the allocation cannot be patched.
+	if (m_buffer.get().mapped != nullptr) { return false; }
+	retired.buffer = vma::move_buffer(command_buffer, m_buffer.get(), m_info, dst);
+	retired.new_buffer = m_buffer.get().buffer;
+	return true;
+}
+
 void RenderBuffer::recreate_impl(CreateInfo create_info) {
-	if (create_info.type == BufferType::Device) { create_info.usage |= vk::BufferUsageFlagBits::eTransferDst; }
+	if (create_info.type != BufferType::Host) { create_info.usage |= vk::BufferUsageFlagBits::eTransferDst; }
 	util::ensure_positive(create_info.size);
 
-	m_buffer = vma::create_buffer(m_render_device->get_allocator(), create_info);
+	m_buffer = get_vma(*m_render_device).create_buffer(create_info);
 	m_info = create_info;
 	m_size = create_info.size;
+	m_address_pinned = false;
+	if (m_movable) { m_buffer.get().allocator->set_movable(m_buffer.get().allocation, this); }
 }
 } // namespace detail
 
 auto IRenderBuffer::create(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info) -> std::unique_ptr<IRenderBuffer> {
-	return std::make_unique<detail::RenderBuffer>(render_device, create_info);
+	auto ret = std::make_unique<detail::RenderBuffer>(render_device, create_info);
+	ret->set_movable();
+	return ret;
 }
 
-auto IRenderBuffer::write_in_place(BufferWrite const write, vk::DeviceSize const offset) -> bool { return write_contiguous({&write, 1}, write.size(), offset); }
+auto IRenderBuffer::write_in_place(BufferWrite const write, vk::DeviceSize const offset, BufferWriteMode const mode) -> bool {
+	return write_contiguous({&write, 1}, write.size(), offset, mode);
+}
 
-void IRenderBuffer::resize_overwrite_contiguous(std::span<BufferWrite const> writes) {
+void IRenderBuffer::resize_overwrite_contiguous(std::span<BufferWrite const> writes, BufferWriteMode const mode) {
 	auto const total_size = std::accumulate(writes.begin(), writes.end(), 0uz, [](std::size_t i, BufferWrite const& w) { return i + w.size(); });
 	resize(total_size);
-	write_contiguous(writes, total_size, 0);
+	write_contiguous(writes, total_size, 0, mode);
 }
 
 auto IRenderBuffer::get_mapped_span() const -> std::span<std::byte> {
@@ -4,10 +4,13 @@
 #include "kvf/render_buffer.hpp"
 
 namespace kvf::detail {
-class RenderBuffer : public IRenderBuffer {
+class RenderBuffer : public IRenderBuffer, public vma::Movable {
   public:
 	explicit RenderBuffer(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info);
 
+	/// \brief Allow defragmentation to relocate this buffer (requires a stable address).
+	void set_movable();
+
   private:
 	void recreate(CreateInfo const& create_info) final { recreate_impl(create_info); }
 
@@ -17,12 +20,17 @@ class RenderBuffer : public IRenderBuffer {
 	[[nodiscard]] auto get_type() const -> BufferType final { return m_info.type; }
 	[[nodiscard]] auto get_buffer() const -> vk::Buffer final { return m_buffer.get().buffer; }
 	[[nodiscard]] auto get_mapped_ptr() const -> void* final { return m_buffer.get().mapped; }
+	[[nodiscard]] auto get_placement() const -> BufferPlacement final { return m_buffer.get().placement; }
+	[[nodiscard]] auto get_device_address() const -> vk::DeviceAddress final;
 
 	[[nodiscard]] auto get_size() const -> vk::DeviceSize final { return m_size; }
 	[[nodiscard]] auto get_capacity() const -> vk::DeviceSize final { return m_info.size; }
 	void resize(vk::DeviceSize size) final;
 
-	auto write_contiguous(std::span<BufferWrite const> writes, vk::DeviceSize write_size, vk::DeviceSize offset) -> bool final;
+	auto write_contiguous(std::span<BufferWrite const> writes, vk::DeviceSize write_size, vk::DeviceSize offset, BufferWriteMode mode) -> bool final;
+	auto write_scattered(std::span<ScatterWrite const> writes, BufferWriteMode mode) -> bool final;
+
+	auto move_to(vk::CommandBuffer command_buffer, VmaAllocation dst, vma::Retired& retired) -> bool final;
 
 	void recreate_impl(CreateInfo create_info);
 
@@ -32,5 +40,8 @@ class RenderBuffer : public IRenderBuffer {
 	vma::UniqueBuffer m_buffer{};
 
 	vk::DeviceSize m_size{};
+	bool m_movable{};
+	// the device address has been handed out: relocation would leave shaders pointing at freed memory.
+	mutable bool m_address_pinned{};
 };
 } // namespace kvf::detail
@@ -2,6 +2,7 @@
 #include "detail/render_buffer.hpp"
 #include "klib/debug/assert.hpp"
 #include "kvf/is_positive.hpp"
+#include "kvf/mip_generator.hpp"
 #include "kvf/render_buffer.hpp"
 #include "kvf/render_device.hpp"
 #include "kvf/scratch_command_buffer.hpp"
@@ -15,10 +16,12 @@ namespace kvf::detail {
 namespace {
 class MipMapCreator {
   public:
-	explicit MipMapCreator(IRenderImage& image, IRenderDevice const& render_device, vk::CommandBuffer command_buffer)
-		: m_image(image), m_render_device(render_device), m_command_buffer(command_buffer) {}
+	explicit MipMapCreator(IRenderImage& image, IRenderDevice const& render_device, vk::CommandBuffer command_buffer, vk::Filter filter)
+		: m_image(image), m_render_device(render_device), m_command_buffer(command_buffer), m_filter(filter) {}
 
-	void record() {
+	/// \brief Regenerate mips (base_mip, mip_levels) from base_mip, leaving [base_mip, mip_levels) in TransferSrcOptimal.
+	/// base_mip must be in the image's current layout.
+	void record(std::uint32_t const base_mip = 0) {
 		m_barrier = m_render_device.create_image_barrier(m_image.get_aspect());
 		m_barrier.setImage(m_image.get_image())
 			.setSrcAccessMask(vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite)
@@ -27,11 +30,12 @@ class MipMapCreator {
 			.setDstStageMask(m_barrier.srcStageMask)
 			.setOldLayout(m_image.get_layout())
 			.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
-		m_barrier.subresourceRange.setAspectMask(m_image.get_aspect()).setLevelCount(1).setLayerCount(m_image.get_layers());
+		m_barrier.subresourceRange.setAspectMask(m_image.get_aspect()).setBaseMipLevel(base_mip).setLevelCount(1).setLayerCount(m_image.get_layers());
 		util::record_barrier(m_command_buffer, m_barrier);
 
-		auto src_extent = vk::Extent3D{m_image.get_extent(), 1};
-		for (std::uint32_t mip = 0; mip + 1 < m_image.get_mip_levels(); ++mip) {
+		auto const extent = m_image.get_extent();
+		auto src_extent = vk::Extent3D{std::max(extent.width >> base_mip, 1u), std::max(extent.height >> base_mip, 1u), 1};
+		for (std::uint32_t mip = base_mip; mip + 1 < m_image.get_mip_levels(); ++mip) {
 			vk::Extent3D dst_extent = vk::Extent3D(std::max(src_extent.width / 2, 1u), std::max(src_extent.height / 2, 1u), 1u);
 			auto const src_offset = vk::Offset3D{static_cast<int>(src_extent.width), static_cast<int>(src_extent.height), 1};
 			auto const dst_offset = vk::Offset3D{static_cast<int>(dst_extent.width), static_cast<int>(dst_extent.height), 1};
@@ -53,7 +57,7 @@ class MipMapCreator {
 			.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal)
 			.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal)
 			.setRegions(ib)
-			.setFilter(vk::Filter::eLinear);
+			.setFilter(m_filter);
 		m_command_buffer.blitImage2(bii);
 	}
 
@@ -71,6 +75,7 @@ class MipMapCreator {
 	IRenderImage& m_image;
 	IRenderDevice const& m_render_device;
 	vk::CommandBuffer m_command_buffer{};
+	vk::Filter m_filter{};
 	vk::ImageMemoryBarrier2 m_barrier{};
 };
 
@@ -82,12 +87,23 @@ template <typename FlagsT, typename BitsT>
 [[nodiscard]] constexpr auto is_copyable(vk::Format const format) { return format == vk::Format::eR8G8B8A8Srgb || format == vk::Format::eR8G8B8A8Unorm; }
 [[nodiscard]] constexpr auto is_copyable(vk::ImageAspectFlags const aspect) { return is_set(aspect, vk::ImageAspectFlagBits::eColor); }
 [[nodiscard]] constexpr auto is_copyable(vk::ImageLayout const layout) { return layout != vk::ImageLayout::eUndefined; }
+
+[[nodiscard]] constexpr auto get_mip_size(vk::Extent2D const extent, std::uint32_t const mip) -> glm::ivec2 {
+	return {int(std::max(extent.width >> mip, 1u)), int(std::max(extent.height >> mip, 1u))};
+}
+
+[[nodiscard]] constexpr auto to_offset(glm::ivec2 const xy) -> vk::Offset3D { return vk::Offset3D{xy.x, xy.y, 0}; }
 } // namespace
 
 RenderImage::RenderImage(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info) : m_render_device(render_device) {
 	recreate_impl(create_info);
 }
 
+void RenderImage::set_movable() {
+	m_movable = true;
+	m_image.get().allocator->set_movable(m_image.get().allocation, this);
+}
+
 void RenderImage::resize(vk::Extent2D extent) {
 	util::ensure_positive(extent);
 	if (extent == m_info.extent) { return; }
@@ -98,6 +114,51 @@ void RenderImage::resize(vk::Extent2D extent) {
 }
 
 auto RenderImage::resize_and_overwrite(std::span<Bitmap const> layers) -> bool {
+	auto retired = Retired{};
+	if (!prepare_overwrite(layers, retired)) { return false; }
+
+	auto const layer_size = layers.front().bytes.size();
+	auto const buffer_ci = BufferCreateInfo{
+		.usage = vk::BufferUsageFlagBits::eTransferSrc,
+		.type = BufferType::Host,
+		.size = layers.size() * layer_size,
+	};
+	auto buffer = detail::RenderBuffer{m_render_device, buffer_ci};
+	auto& staging = static_cast<IRenderBuffer&>(buffer);
+
+	auto span = staging.get_mapped_span();
+	for (auto const& layer : layers) {
+		std::memcpy(span.data(), layer.bytes.data(), layer_size);
+		span = span.subspan(layer_size);
+	}
+
+	auto cmd = ScratchCommandBuffer{m_render_device};
+	record_overwrite(cmd, staging.get_buffer(), 0);
+	return cmd.submit_and_wait();
+}
+
+auto RenderImage::update_region(glm::ivec2 const offset, Bitmap const& bitmap, std::uint32_t const layer, std::uint32_t const mip) -> bool {
+	auto const region = Region{.offset = offset, .size = bitmap.size, .layer = layer, .mip = mip};
+	if (!can_update(region) || bitmap.bytes.size() != std::size_t(bitmap.size.x * bitmap.size.y) * Bitmap::channels_v) {
+		log.warn("RenderImage: Invalid region/layout/format/aspect for update");
+		return false;
+	}
+
+	auto const buffer_ci = BufferCreateInfo{
+		.usage = vk::BufferUsageFlagBits::eTransferSrc,
+		.type = BufferType::Host,
+		.size = bitmap.bytes.size(),
+	};
+	auto buffer = detail::RenderBuffer{m_render_device, buffer_ci};
+	auto& staging = static_cast<IRenderBuffer&>(buffer);
+	std::memcpy(staging.get_mapped_span().data(), bitmap.bytes.data(), bitmap.bytes.size());
+
+	auto cmd = ScratchCommandBuffer{m_render_device};
+	record_update(cmd, staging.get_buffer(), 0, region);
+	return cmd.submit_and_wait();
+}
+
+auto RenderImage::prepare_overwrite(std::span<Bitmap const>& layers, Retired& out_retired) -> bool {
 	if (layers.empty()) { return false; }
 
 	auto size = layers.front().size;
@@ -111,29 +172,35 @@ auto RenderImage::resize_and_overwrite(std::span<Bitmap const> layers) -> bool {
 	auto const layer_size = vk::DeviceSize(extent.width * extent.height * Bitmap::channels_v);
 	KLIB_ASSERT(layer_size > 0);
 
-	if (!m_image.get().image || m_info.layers != std::uint32_t(layers.size())) {
-		m_info.layers = std::uint32_t(layers.size());
-		m_info.extent = extent;
-		recreate(m_info);
-	}
-
-	auto const total_size = layers.size() * layer_size;
 	auto const check = [size, layer_size](Bitmap const& b) { return b.size == size && b.bytes.size() == layer_size; };
 	if (!std::ranges::all_of(layers, check)) { return false; }
 
-	resize(extent);
+	auto const layer_count = std::uint32_t(layers.size());
+	if (m_image.get().image && m_info.layers == layer_count && m_info.extent == extent) { return true; }
 
+	// frames in flight may still be sampling the current image.
+	if (m_image.get().image) {
+		m_image.get().allocator->set_movable(m_image.get().allocation, nullptr);
+		// descriptors referencing the current view must be rewritten to the new one.
+		m_image.get().allocator->record_release(vma::to_word(get_image_view()));
+		out_retired = Retired{.image = std::move(m_image), .image_view = std::move(m_image_view)};
+	}
+	m_info.layers = layer_count;
+	m_info.extent = extent;
+	recreate(m_info);
+	return true;
+}
+
+void RenderImage::record_overwrite(vk::CommandBuffer const cmd, vk::Buffer const staging, vk::DeviceSize const offset) {
 	auto const original_layout = get_layout();
+	record_copy(cmd, staging, offset);
+	record_finalize(cmd, original_layout == vk::ImageLayout::eUndefined ? vk::ImageLayout::eShaderReadOnlyOptimal : original_layout);
+}
 
-	auto const buffer_ci = BufferCreateInfo{
-		.usage = vk::BufferUsageFlagBits::eTransferSrc,
-		.type = BufferType::Host,
-		.size = total_size,
-	};
-	auto buffer = detail::RenderBuffer{m_render_device, buffer_ci};
-	auto& staging = static_cast<IRenderBuffer&>(buffer);
+void RenderImage::record_copy(vk::CommandBuffer const cmd, vk::Buffer const staging, vk::DeviceSize const offset) {
+	auto const extent = m_info.extent;
+	auto const layer_size = vk::DeviceSize(extent.width * extent.height * Bitmap::channels_v);
 
-	auto cmd = ScratchCommandBuffer{m_render_device};
 	auto barrier = vk::ImageMemoryBarrier2{};
 	barrier.setSrcAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
 		.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
@@ -143,31 +210,34 @@ auto RenderImage::resize_and_overwrite(std::span<Bitmap const> layers) -> bool {
 		.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
 	transition(cmd, barrier);
 
-	auto span = staging.get_mapped_span();
-	auto buffer_offset = vk::DeviceSize{};
+	auto buffer_offset = offset;
 	auto cbtii = vk::CopyBufferToImageInfo2{};
-	cbtii.setDstImage(get_image()).setDstImageLayout(vk::ImageLayout::eTransferDstOptimal).setSrcBuffer(staging.get_buffer());
-	for (auto const [index, layer] : std::views::enumerate(layers)) {
-		std::memcpy(span.data(), layer.bytes.data(), layer_size);
-
+	cbtii.setDstImage(get_image()).setDstImageLayout(vk::ImageLayout::eTransferDstOptimal).setSrcBuffer(staging);
+	for (std::uint32_t layer = 0; layer < m_info.layers; ++layer) {
 		auto bic = vk::BufferImageCopy2{};
 		bic.setImageExtent({extent.width, extent.height, 1})
-			.setImageSubresource(vk::ImageSubresourceLayers{m_info.aspect, 0, std::uint32_t(index), 1})
+			.setImageSubresource(vk::ImageSubresourceLayers{m_info.aspect, 0, layer, 1})
 			.setBufferOffset(buffer_offset);
 		cbtii.setRegions(bic);
-		cmd.get().copyBufferToImage2(cbtii);
+		cmd.copyBufferToImage2(cbtii);
 
-		span = span.subspan(layer_size);
 		buffer_offset += layer_size;
 	}
+}
+
+void RenderImage::record_finalize(vk::CommandBuffer const cmd, vk::ImageLayout const final_layout) {
+	if (get_mip_levels() > 1 && (m_info.flags & ImageFlag::ComputeMipMaps) == ImageFlag::ComputeMipMaps) {
+		auto const mip_generator = m_render_device->get_mip_generator();
+		if (mip_generator && mip_generator->record(cmd, *this, m_info.mip_filter, final_layout)) { return; }
+	}
 
 	auto current_layout = get_layout();
 	if (get_mip_levels() > 1) {
-		MipMapCreator{*this, *m_render_device, cmd}.record();
+		MipMapCreator{*this, *m_render_device, cmd, get_mip_filter()}.record();
 		current_layout = vk::ImageLayout::eTransferSrcOptimal;
 	}
 
-	auto const final_layout = original_layout == vk::ImageLayout::eUndefined ? vk::ImageLayout::eShaderReadOnlyOptimal : original_layout;
+	auto barrier = vk::ImageMemoryBarrier2{};
 	barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite)
 		.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
 		.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
@@ -175,13 +245,156 @@ auto RenderImage::resize_and_overwrite(std::span<Bitmap const> layers) -> bool {
 		.setOldLayout(current_layout)
 		.setNewLayout(final_layout);
 	transition(cmd, barrier);
+}
 
-	return cmd.submit_and_wait();
+auto RenderImage::can_update(Region const& region) const -> bool {
+	if (!is_copyable(m_layout) || !is_copyable(m_info.format) || !is_copyable(m_info.aspect) || !is_set(m_info.usage, vk::ImageUsageFlagBits::eTransferDst)) {
+		return false;
+	}
+	if (region.layer >= m_info.layers || region.mip >= get_mip_levels()) { return false; }
+	if (!is_positive(region.size) || region.offset.x < 0 || region.offset.y < 0) { return false; }
+	auto const mip_size = get_mip_size(m_info.extent, region.mip);
+	return region.offset.x + region.size.x <= mip_size.x && region.offset.y + region.size.y <= mip_size.y;
 }
 
-auto RenderImage::copy_to_bitmap(vk::Extent2D custom_extent) const -> std::optional<ColorBitmap> {
-	if (m_info.layers != 1 || !is_copyable(m_layout) || !is_copyable(m_info.format) || !is_copyable(m_info.aspect)) {
-		log.warn("RenderImage: Invalid layers/layout/format/aspect for copying");
+void RenderImage::record_update(vk::CommandBuffer const cmd, vk::Buffer const staging, vk::DeviceSize const offset, Region const& region) {
+	KLIB_ASSERT(can_update(region));
+	auto const mip_levels = get_mip_levels();
+
+	// existing contents are preserved: transition from the current layout, and only the region's layer and mips [region.mip, mip_levels).
+	auto barrier = m_render_device->create_image_barrier(m_info.aspect);
+	barrier.setImage(get_image())
+		.setSrcAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+		.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+		.setDstAccessMask(vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite)
+		.setDstStageMask(vk::PipelineStageFlagBits2::eTransfer)
+		.setOldLayout(m_layout)
+		.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
+	barrier.subresourceRange.setBaseMipLevel(region.mip).setLevelCount(mip_levels - region.mip).setBaseArrayLayer(region.layer).setLayerCount(1);
+	util::record_barrier(cmd, barrier);
+
+	auto bic = vk::BufferImageCopy2{};
+	bic.setBufferOffset(offset)
+		.setImageSubresource(vk::ImageSubresourceLayers{m_info.aspect, region.mip, region.layer, 1})
+		.setImageOffset(to_offset(region.offset))
+		.setImageExtent(vk::Extent3D{std::uint32_t(region.size.x), std::uint32_t(region.size.y), 1});
+	auto cbtii = vk::CopyBufferToImageInfo2{};
+	cbtii.setDstImage(get_image()).setDstImageLayout(vk::ImageLayout::eTransferDstOptimal).setSrcBuffer(staging).setRegions(bic);
+	cmd.copyBufferToImage2(cbtii);
+
+	if (!is_footprint_exact(region.mip)) {
+		// lower mips are regenerated in full, exactly as on upload.
+		barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+			.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
+			.setDstAccessMask(vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite)
+			.setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setNewLayout(m_layout);
+		util::record_barrier(cmd, barrier);
+		if (region.mip == 0) {
+			record_finalize(cmd, m_layout);
+			return;
+		}
+		auto const final_layout = m_layout;
+		MipMapCreator{*this, *m_render_device, cmd, get_mip_filter()}.record(region.mip);
+		barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite)
+			.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+			.setOldLayout(vk::ImageLayout::eTransferSrcOptimal)
+			.setNewLayout(final_layout);
+		barrier.subresourceRange.setBaseArrayLayer(0).setLayerCount(m_info.layers);
+		util::record_barrier(cmd, barrier);
+		return;
+	}
+
+	// regenerate the dirty rect's footprint in each lower mip: [lo, hi) halves (rounding outwards) per level.
+	// only used where it matches full mip generation exactly: every level's extent is even (or 1).
+	auto src_lo = region.offset;
+	auto src_hi = region.offset + region.size;
+	auto src_size = get_mip_size(m_info.extent, region.mip);
+	barrier.subresourceRange.setLevelCount(1);
+	for (auto mip = region.mip; mip + 1 < mip_levels; ++mip) {
+		barrier.subresourceRange.setBaseMipLevel(mip);
+		barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+			.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
+			.setDstAccessMask(vk::AccessFlagBits2::eTransferRead)
+			.setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
+		util::record_barrier(cmd, barrier);
+
+		auto const dst_size = get_mip_size(m_info.extent, mip + 1);
+		auto const dst_lo = src_lo / 2;
+		auto const dst_hi = glm::ivec2{std::min((src_hi.x + 1) / 2, dst_size.x), std::min((src_hi.y + 1) / 2, dst_size.y)};
+		auto const blit_lo = dst_lo * 2;
+		auto const blit_hi = glm::ivec2{
+			dst_hi.x == dst_size.x ? src_size.x : std::min(dst_hi.x * 2, src_size.x),
+			dst_hi.y == dst_size.y ? src_size.y : std::min(dst_hi.y * 2, src_size.y),
+		};
+
+		auto ib = vk::ImageBlit2{};
+		ib.srcSubresource = vk::ImageSubresourceLayers{m_info.aspect, mip, region.layer, 1};
+		ib.dstSubresource = vk::ImageSubresourceLayers{m_info.aspect, mip + 1, region.layer, 1};
+		ib.srcOffsets = std::array{to_offset(blit_lo), vk::Offset3D{blit_hi.x, blit_hi.y, 1}};
+		ib.dstOffsets = std::array{to_offset(dst_lo), vk::Offset3D{dst_hi.x, dst_hi.y, 1}};
+		auto bii = vk::BlitImageInfo2{};
+		bii.setSrcImage(get_image())
+			.setDstImage(get_image())
+			.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal)
+			.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setRegions(ib)
+			.setFilter(get_mip_filter());
+		cmd.blitImage2(bii);
+
+		src_lo = dst_lo;
+		src_hi = dst_hi;
+		src_size = dst_size;
+	}
+
+	// restore the original layout: mips [region.mip, mip_levels - 1) are TransferSrc, the last one is TransferDst.
+	auto barriers = std::array<vk::ImageMemoryBarrier2, 2>{barrier, barrier};
+	for (auto& b : barriers) {
+		b.setSrcAccessMask(vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite)
+			.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
+			.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+			.setNewLayout(m_layout);
+	}
+	barriers[0].setOldLayout(vk::ImageLayout::eTransferSrcOptimal);
+	barriers[0].subresourceRange.setBaseMipLevel(region.mip).setLevelCount(mip_levels - 1 - region.mip);
+	barriers[1].setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+	barriers[1].subresourceRange.setBaseMipLevel(mip_levels - 1);
+	auto const span = std::span{barriers};
+	util::record_barriers(cmd, barriers[0].subresourceRange.levelCount > 0 ? span : span.subspan(1));
+}
+
+auto RenderImage::is_footprint_exact(std::uint32_t const base_mip) const -> bool {
+	auto const mip_levels = get_mip_levels();
+	if (base_mip + 1 >= mip_levels) { return true; }
+	// compute mip maps are generated with their own filter.
+	if (base_mip == 0 && (m_info.flags & ImageFlag::ComputeMipMaps) == ImageFlag::ComputeMipMaps) {
+		auto const mip_generator = m_render_device->get_mip_generator();
+		if (mip_generator && mip_generator->is_supported(*this)) { return false; }
+	}
+	static constexpr auto is_halvable = [](int const size) { return size == 1 || size % 2 == 0; };
+	for (auto mip = base_mip; mip + 1 < mip_levels; ++mip) {
+		auto const size = get_mip_size(m_info.extent, mip);
+		if (!is_halvable(size.x) || !is_halvable(size.y)) { return false; }
+	}
+	return true;
+}
+
+auto RenderImage::get_mip_filter() const -> vk::Filter {
+	auto const features = m_render_device->get_gpu().device.getFormatProperties(m_info.format).optimalTilingFeatures;
+	return is_set(features, vk::FormatFeatureFlagBits::eSampledImageFilterLinear) ? vk::Filter::eLinear : vk::Filter::eNearest;
+}
+
+auto RenderImage::copy_to_bitmap(vk::Extent2D const custom_extent) const -> std::optional<ColorBitmap> {
+	return copy_extent_to_bitmap(m_info.extent, custom_extent);
+}
+
+auto RenderImage::copy_extent_to_bitmap(vk::Extent2D source_extent, vk::Extent2D custom_extent) const -> std::optional<ColorBitmap> {
+	if (m_info.layers != 1 || !is_copyable(m_layout) || !is_copyable(m_info.format) || !is_copyable(m_info.aspect) ||
+		!is_set(m_info.usage, vk::ImageUsageFlagBits::eTransferSrc)) {
+		log.warn("RenderImage: Invalid layers/layout/format/aspect/usage for copying");
 		return {};
 	}
 
@@ -192,10 +405,11 @@ auto RenderImage::copy_to_bitmap(vk::Extent2D custom_extent) const -> std::optio
 		return {};
 	}
 
-	if (custom_extent.width == 0 || custom_extent.height == 0) { custom_extent = m_info.extent; }
+	source_extent = vk::Extent2D{std::min(source_extent.width, m_info.extent.width), std::min(source_extent.height, m_info.extent.height)};
+	if (custom_extent.width == 0 || custom_extent.height == 0) { custom_extent = source_extent; }
 
 	auto command_buffer = ScratchCommandBuffer{m_render_device};
-	auto const dst_image = blit_for_copy(command_buffer, custom_extent);
+	auto const dst_image = blit_for_copy(command_buffer, source_extent, custom_extent);
 	command_buffer.submit_and_wait();
 
 	KLIB_ASSERT(dst_image.get().mapped);
@@ -226,22 +440,57 @@ void RenderImage::transition(vk::CommandBuffer const command_buffer, vk::ImageMe
 }
 
 void RenderImage::recreate_impl(CreateInfo create_info) {
-	create_info.usage |= CreateInfo::implicit_usage_v;
+	if ((create_info.flags & ImageFlag::Transient) == ImageFlag::Transient) {
+		static constexpr auto attachment_usage_v =
+			vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment;
+		create_info.usage = (create_info.usage & attachment_usage_v) | vk::ImageUsageFlagBits::eTransientAttachment;
+		create_info.flags &= ~ImageFlag::MipMaps;
+	} else {
+		create_info.usage |= CreateInfo::implicit_usage_v;
+		if ((create_info.flags & ImageFlag::ComputeMipMaps) == ImageFlag::ComputeMipMaps) { create_info.usage |= vk::ImageUsageFlagBits::eStorage; }
+	}
 	if (create_info.format == vk::Format::eUndefined) { create_info.format = vk::Format::eR8G8B8A8Srgb; }
 	util::ensure_positive(create_info.extent);
 
 	if (create_info.extent.width == 1 || create_info.extent.height == 1) { create_info.flags &= ~ImageFlag::MipMaps; }
-	m_image = vma::create_image(m_render_device->get_allocator(), m_render_device->get_queue_family(), create_info);
+	m_image = get_vma(*m_render_device).create_image(m_render_device->get_queue_family(), create_info);
 	m_info = create_info;
+	create_image_view();
+	m_layout = vk::ImageLayout::eUndefined;
+	if (m_movable) { m_image.get().allocator->set_movable(m_image.get().allocation, this); }
+}
 
+void RenderImage::create_image_view() {
+	// storage (for compute mip maps) is only used through UNORM views.
+	auto const is_unorm = util::to_unorm(m_info.format) == m_info.format;
 	auto const image_view_ci = util::ImageViewCreateInfo{
 		.image = m_image.get().image,
-		.format = create_info.format,
+		.format = m_info.format,
 		.subresource = subresource_range(),
-		.type = create_info.view_type,
+		.type = m_info.view_type,
+		.usage = is_unorm ? vk::ImageUsageFlags{} : m_info.usage & ~vk::ImageUsageFlags{vk::ImageUsageFlagBits::eStorage},
 	};
-	m_image_view = util::create_image_view(m_render_device->get_device(), image_view_ci);
-	m_layout = vk::ImageLayout::eUndefined;
+	m_image_view = m_image.get().allocator->create_image_view(image_view_ci);
+}
+
+auto RenderImage::move_to(vk::CommandBuffer const command_buffer, VmaAllocation dst, vma::Retired& retired) -> bool {
+	// transient attachments may be lazily allocated, and are only used within a render pass.
+	if ((m_info.flags & ImageFlag::Transient) == ImageFlag::Transient) { return false; }
+	retired.image = vma::move_image(command_buffer, m_image.get(), m_render_device->get_queue_family(), m_info, m_layout, dst);
+	retired.image_view = std::move(m_image_view);
+	create_image_view();
+	return true;
+}
+
+auto RenderImage::get_ownership_barrier(std::uint32_t const src_family, std::uint32_t const dst_family) const -> vk::ImageMemoryBarrier2 {
+	auto ret = vk::ImageMemoryBarrier2{};
+	ret.setImage(get_image())
+		.setOldLayout(m_layout)
+		.setNewLayout(m_layout)
+		.setSrcQueueFamilyIndex(src_family)
+		.setDstQueueFamilyIndex(dst_family)
+		.setSubresourceRange(subresource_range());
+	return ret;
 }
 
 auto RenderImage::get_pre_render_barrier() -> vk::ImageMemoryBarrier2 {
@@ -252,10 +501,17 @@ auto RenderImage::get_pre_render_barrier() -> vk::ImageMemoryBarrier2 {
 		.setSrcStageMask(vk::PipelineStageFlagBits2::eFragmentShader | vk::PipelineStageFlagBits2::eTransfer)
 		.setNewLayout(m_layout)
 		.setOldLayout(vk::ImageLayout::eUndefined);
+	// attachment writes are also waited on: images shared across frames in flight may still be written to by a previous frame.
 	if (m_info.aspect == vk::ImageAspectFlagBits::eDepth) {
-		ret.setDstAccessMask(vk::AccessFlagBits2::eDepthStencilAttachmentWrite).setDstStageMask(vk::PipelineStageFlagBits2::eEarlyFragmentTests);
+		ret.setSrcAccessMask(ret.srcAccessMask | vk::AccessFlagBits2::eDepthStencilAttachmentWrite)
+			.setSrcStageMask(ret.srcStageMask | vk::PipelineStageFlagBits2::eLateFragmentTests)
+			.setDstAccessMask(vk::AccessFlagBits2::eDepthStencilAttachmentWrite)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests);
 	} else {
-		ret.setDstAccessMask(vk::AccessFlagBits2::eColorAttachmentWrite).setDstStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+		ret.setSrcAccessMask(ret.srcAccessMask | vk::AccessFlagBits2::eColorAttachmentWrite)
+			.setSrcStageMask(ret.srcStageMask | vk::PipelineStageFlagBits2::eColorAttachmentOutput)
+			.setDstAccessMask(vk::AccessFlagBits2::eColorAttachmentWrite)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eColorAttachmentOutput);
 	}
 	return ret;
 }
@@ -276,14 +532,15 @@ auto RenderImage::get_post_render_barrier() -> vk::ImageMemoryBarrier2 {
 	return ret;
 }
 
-auto RenderImage::blit_for_copy(vk::CommandBuffer const command_buffer, vk::Extent2D const extent) const -> vma::UniqueImage {
+auto RenderImage::blit_for_copy(vk::CommandBuffer const command_buffer, vk::Extent2D const src_extent, vk::Extent2D const dst_extent) const
+	-> vma::UniqueImage {
 	KLIB_ASSERT(m_layout != vk::ImageLayout::eUndefined);
 
 	auto const dst_image_ci = CreateInfo{
 		.format = m_info.format,
-		.extent = extent,
+		.extent = dst_extent,
 	};
-	auto dst_image = vma::create_image_for_copy(m_image.get().allocator, m_render_device->get_queue_family(), dst_image_ci);
+	auto dst_image = m_image.get().allocator->create_image_for_copy(m_render_device->get_queue_family(), dst_image_ci);
 
 	auto barriers = std::array<vk::ImageMemoryBarrier2, 2>{};
 	barriers[0] = m_render_device->create_image_barrier();
@@ -313,8 +570,8 @@ auto RenderImage::blit_for_copy(vk::CommandBuffer const command_buffer, vk::Exte
 	subresource_layers.setAspectMask(vk::ImageAspectFlagBits::eColor).setLayerCount(1);
 
 	auto image_blit = vk::ImageBlit2{};
-	image_blit.setSrcOffsets({vk::Offset3D{}, to_offset(m_info.extent)})
-		.setDstOffsets({vk::Offset3D{}, to_offset(extent)})
+	image_blit.setSrcOffsets({vk::Offset3D{}, to_offset(src_extent)})
+		.setDstOffsets({vk::Offset3D{}, to_offset(dst_extent)})
 		.setSrcSubresource(subresource_layers)
 		.setDstSubresource(subresource_layers);
 
@@ -349,7 +606,9 @@ auto RenderImage::blit_for_copy(vk::CommandBuffer const command_buffer, vk::Exte
 
 namespace kvf {
 auto IRenderImage::create(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info) -> std::unique_ptr<IRenderImage> {
-	return std::make_unique<detail::RenderImage>(render_device, create_info);
+	auto ret = std::make_unique<detail::RenderImage>(render_device, create_info);
+	ret->set_movable();
+	return ret;
 }
 
 auto IRenderImage::create_texture(gsl::not_null<IRenderDevice*> render_device, Bitmap bitmap, bool const mip_map) -> std::unique_ptr<IRenderImage> {
@@ -4,18 +4,52 @@
 #include "kvf/render_image.hpp"
 
 namespace kvf::detail {
-class RenderImage : public IRenderImage {
+class RenderImage : public IRenderImage, public vma::Movable {
   public:
+	struct Region {
+		glm::ivec2 offset{};
+		glm::ivec2 size{};
+		std::uint32_t layer{};
+		std::uint32_t mip{};
+	};
+
+	/// \brief Image and view replaced by prepare_overwrite(), to be destroyed once frames using them have completed.
+	struct Retired {
+		vma::UniqueImage image{};
+		vma::UniqueImageView image_view{};
+	};
+
 	explicit RenderImage(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info);
 
+	/// \brief Allow defragmentation to relocate this image (requires a stable address).
+	void set_movable();
+
 	[[nodiscard]] auto get_format() const -> vk::Format final { return m_info.format; }
-	[[nodiscard]] auto get_image_view() const -> vk::ImageView final { return *m_image_view; }
+	[[nodiscard]] auto get_image_view() const -> vk::ImageView final { return m_image_view.get().view; }
+	[[nodiscard]] auto get_create_info() const -> CreateInfo const& { return m_info; }
 
 	void resize(vk::Extent2D extent) final;
 
 	[[nodiscard]] auto get_pre_render_barrier() -> vk::ImageMemoryBarrier2;
 	[[nodiscard]] auto get_post_render_barrier() -> vk::ImageMemoryBarrier2;
 
+	/// \brief Validate layers and (re)create image to match them, handing the previous image and view to out_retired.
+	[[nodiscard]] auto prepare_overwrite(std::span<Bitmap const>& layers, Retired& out_retired) -> bool;
+	/// \brief Record copy of layers staged contiguously at offset, mip map generation, and transition to sampling layout.
+	void record_overwrite(vk::CommandBuffer command_buffer, vk::Buffer staging, vk::DeviceSize offset);
+	/// \brief Record transition to TransferDstOptimal and copy of layers staged contiguously at offset.
+	void record_copy(vk::CommandBuffer command_buffer, vk::Buffer staging, vk::DeviceSize offset);
+	/// \brief Record mip map generation and transition to final_layout.
+	void record_finalize(vk::CommandBuffer command_buffer, vk::ImageLayout final_layout);
+	[[nodiscard]] auto can_update(Region const& region) const -> bool;
+	/// \brief Record copy of region staged at offset, and regeneration of lower mips: only its footprint where that matches
+	/// full generation, otherwise all of them (via the mip generator for ComputeMipMaps images).
+	void record_update(vk::CommandBuffer command_buffer, vk::Buffer staging, vk::DeviceSize offset, Region const& region);
+	/// \brief Copy the top-left source_extent texels of the image, scaled to custom_extent (source_extent if zero).
+	[[nodiscard]] auto copy_extent_to_bitmap(vk::Extent2D source_extent, vk::Extent2D custom_extent) const -> std::optional<ColorBitmap>;
+	/// \brief Queue family ownership transfer barrier (without layout transition); stage / access masks are left to the caller.
+	[[nodiscard]] auto get_ownership_barrier(std::uint32_t src_family, std::uint32_t dst_family) const -> vk::ImageMemoryBarrier2;
+
   private:
 	void recreate(CreateInfo const& create_info) final { recreate_impl(create_info); }
 
@@ -32,20 +66,29 @@ class RenderImage : public IRenderImage {
 	[[nodiscard]] auto get_mip_levels() const -> std::uint32_t final { return m_image.get().mip_levels; }
 
 	auto resize_and_overwrite(std::span<Bitmap const> layers) -> bool final;
+	auto update_region(glm::ivec2 offset, Bitmap const& bitmap, std::uint32_t layer, std::uint32_t mip) -> bool final;
 	[[nodiscard]] auto copy_to_bitmap(vk::Extent2D custom_extent) const -> std::optional<ColorBitmap> final;
 
 	void transition(vk::CommandBuffer command_buffer, vk::ImageMemoryBarrier2 barrier) final;
 
+	auto move_to(vk::CommandBuffer command_buffer, VmaAllocation dst, vma::Retired& retired) -> bool final;
+
 	void recreate_impl(CreateInfo create_info);
+	void create_image_view();
+
+	/// \brief Whether blitting dirty footprints from base_mip down matches full mip generation.
+	[[nodiscard]] auto is_footprint_exact(std::uint32_t base_mip) const -> bool;
+	[[nodiscard]] auto get_mip_filter() const -> vk::Filter;
 
-	[[nodiscard]] auto blit_for_copy(vk::CommandBuffer command_buffer, vk::Extent2D extent) const -> vma::UniqueImage;
+	[[nodiscard]] auto blit_for_copy(vk::CommandBuffer command_buffer, vk::Extent2D src_extent, vk::Extent2D dst_extent) const -> vma::UniqueImage;
 
 	gsl::not_null<IRenderDevice*> m_render_device;
 
 	CreateInfo m_info{};
 	vma::UniqueImage m_image{};
-	vk::UniqueImageView m_image_view{};
+	vma::UniqueImageView m_image_view{};
 
 	vk::ImageLayout m_layout{};
+	bool m_movable{};
 };
 } // namespace kvf::detail
@@ -1,11 +1,15 @@
 #include "detail/render_pass.hpp"
 #include "kvf/render_device.hpp"
 #include "kvf/util.hpp"
+#include <algorithm>
 #include <array>
+#include <utility>
 
 namespace kvf::detail {
-RenderPass::RenderPass(gsl::not_null<IRenderDevice*> render_device, vk::SampleCountFlagBits const samples)
-	: m_render_device(render_device), m_samples(samples) {}
+RenderPass::RenderPass(gsl::not_null<IRenderDevice*> render_device, vk::SampleCountFlagBits const samples, RenderPassFlag const flags)
+	: m_render_device(render_device), m_samples(samples), m_flags(flags) {
+	m_render_device->attach_next_frame_listener(m_per_frame);
+}
 
 void RenderPass::set_color_target(vk::Format format) {
 	if (format == vk::Format::eUndefined) {
@@ -26,15 +30,26 @@ void RenderPass::set_color_target(vk::Format format) {
 		ret.extent = m_extent;
 		return ret;
 	}();
-	if (has_color_target()) { m_render_device->get_device().waitIdle(); }
+	reset_targets(true, false);
+	if (use_transient_color()) {
+		auto transient_ici = color_ici;
+		transient_ici.flags |= ImageFlag::Transient;
+		m_transient_color.emplace(m_render_device, transient_ici);
+	}
+	auto const has_resolve = m_samples > vk::SampleCountFlagBits::e1;
+	if (use_pool()) {
+		if (!m_transient_color) { m_pooled_keys.color = RenderTargetKey{.format = format, .samples = m_samples, .usage = color_ici.usage}; }
+		if (has_resolve) { m_pooled_keys.resolve = RenderTargetKey{.format = format, .usage = resolve_ici.usage}; }
+		return;
+	}
 	for (auto& framebuffer : m_framebuffers) {
-		framebuffer.color.emplace(m_render_device, color_ici);
-		if (m_samples > vk::SampleCountFlagBits::e1) { framebuffer.resolve.emplace(m_render_device, resolve_ici); }
+		if (!m_transient_color) { framebuffer.color.emplace(m_render_device, color_ici); }
+		if (has_resolve) { framebuffer.resolve.emplace(m_render_device, resolve_ici); }
 	}
 }
 
 void RenderPass::set_depth_target() {
-	auto const depth_ici = ImageCreateInfo{
+	auto depth_ici = ImageCreateInfo{
 		.format = m_render_device->get_optimal_depth_format(),
 		.aspect = vk::ImageAspectFlagBits::eDepth,
 		.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment,
@@ -42,18 +57,26 @@ void RenderPass::set_depth_target() {
 		.flags = ImageFlag::DedicatedAlloc,
 		.extent = m_extent,
 	};
+	reset_targets(false, true);
+	if (use_transient_depth()) {
+		depth_ici.flags |= ImageFlag::Transient;
+		m_transient_depth.emplace(m_render_device, depth_ici);
+		return;
+	}
+	if (use_pool()) {
+		m_pooled_keys.depth = RenderTargetKey{.format = depth_ici.format, .samples = m_samples, .usage = depth_ici.usage, .aspect = depth_ici.aspect};
+		return;
+	}
 	for (auto& framebuffer : m_framebuffers) { framebuffer.depth.emplace(m_render_device, depth_ici); }
 }
 
 void RenderPass::recreate(vk::SampleCountFlagBits const samples) {
 	auto const had_color = has_color_target();
 	auto const had_depth = has_depth_target();
+	auto const color_format = get_color_format();
 	m_samples = samples;
-	if (had_color) { set_color_target(get_color_format()); }
+	if (had_color) { set_color_target(color_format); }
 	if (had_depth) { set_depth_target(); }
-	if (m_samples == vk::SampleCountFlagBits::e1) {
-		for (auto& framebuffer : m_framebuffers) { framebuffer.resolve.reset(); }
-	}
 }
 
 auto RenderPass::create_graphics_pipeline(vk::PipelineLayout const layout, PipelineState const& state) -> vk::UniquePipeline {
@@ -67,11 +90,15 @@ auto RenderPass::create_graphics_pipeline(vk::PipelineLayout const layout, Pipel
 
 auto RenderPass::get_color_format() const -> vk::Format {
 	if (!has_color_target()) { return vk::Format::eUndefined; }
+	if (m_transient_color) { return m_transient_color->get_format(); }
+	if (m_pooled_keys.color) { return m_pooled_keys.color->format; }
 	return m_framebuffers[0].color->get_format();
 }
 
 auto RenderPass::get_depth_format() const -> vk::Format {
 	if (!has_depth_target()) { return vk::Format::eUndefined; }
+	if (m_transient_depth) { return m_transient_depth->get_format(); }
+	if (m_pooled_keys.depth) { return m_pooled_keys.depth->format; }
 	return m_framebuffers[0].depth->get_format();
 }
 
@@ -79,11 +106,17 @@ void RenderPass::begin_render(vk::CommandBuffer const command_buffer, vk::Extent
 	if (!command_buffer || (!has_color_target() && !has_depth_target())) { return; }
 
 	util::ensure_positive(extent);
-	m_extent = extent;
+	auto const previous = std::exchange(m_extent, extent);
+	update_capacity(previous);
 	m_command_buffer = command_buffer;
 
-	auto& framebuffer = m_framebuffers.at(std::size_t(m_render_device->get_frame_index()));
-	prep_for_render(framebuffer);
+	// depth_store_op may have changed since the depth target was created.
+	if (has_depth_target() && m_transient_depth.has_value() != use_transient_depth()) { set_depth_target(); }
+
+	auto const frame_index = std::size_t(m_render_device->get_frame_index());
+	if (use_pool()) { acquire_pooled(frame_index); }
+	prep_for_render(m_framebuffers.at(frame_index));
+	auto const framebuffer = get_attachments(frame_index);
 
 	m_barriers.clear();
 	if (framebuffer.color) { m_barriers.push_back(framebuffer.color->get_pre_render_barrier()); }
@@ -99,7 +132,8 @@ void RenderPass::begin_render(vk::CommandBuffer const command_buffer, vk::Extent
 		color_ai.setImageView(framebuffer.color->get_image_view())
 			.setImageLayout(vk::ImageLayout::eAttachmentOptimal)
 			.setLoadOp(vk::AttachmentLoadOp::eClear)
-			.setStoreOp(vk::AttachmentStoreOp::eStore)
+			// transient color is always resolved: storing it would force lazily allocated memory to be committed.
+			.setStoreOp(m_transient_color ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore)
 			.setClearValue(vk::ClearColorValue{cc.x, cc.y, cc.z, cc.w});
 	}
 	if (framebuffer.resolve) {
@@ -129,22 +163,60 @@ auto RenderPass::allocate_sets(std::span<vk::DescriptorSet> out_sets, std::span<
 	return m_render_device->get_descriptor_allocator().allocate_next(out_sets, sets_layouts);
 }
 
+auto RenderPass::push_descriptors(vk::PipelineLayout const pipeline_layout, std::uint32_t const set, PushSetLayout const& set_layout,
+								  std::span<DescriptorBinding const> bindings) -> bool {
+	if (!m_command_buffer) { return false; }
+
+	auto descriptor_set = vk::DescriptorSet{};
+	if (!set_layout.push && !allocate_sets({&descriptor_set, 1}, {&*set_layout.layout, 1})) { return false; }
+
+	m_writes.clear();
+	for (auto const& binding : bindings) {
+		auto const wds = binding.to_write(descriptor_set);
+		if (wds.descriptorCount > 0) { m_writes.push_back(wds); }
+	}
+
+	if (!descriptor_set) {
+		m_command_buffer.pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, pipeline_layout, set, m_writes);
+		return true;
+	}
+
+	m_render_device->get_device().updateDescriptorSets(m_writes, {});
+	m_command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline_layout, set, descriptor_set, {});
+	return true;
+}
+
 void RenderPass::end_render() {
 	if (!m_command_buffer) { return; }
 
 	m_command_buffer.endRendering();
 
-	auto& framebuffer = m_framebuffers.at(std::size_t(m_render_device->get_frame_index()));
+	auto const framebuffer = get_attachments(std::size_t(m_render_device->get_frame_index()));
 
+	// transient attachments are never sampled: they stay in attachment layout.
 	m_barriers.clear();
-	if (framebuffer.color) { m_barriers.push_back(framebuffer.color->get_post_render_barrier()); }
+	if (framebuffer.color && !m_transient_color) { m_barriers.push_back(framebuffer.color->get_post_render_barrier()); }
 	if (framebuffer.resolve) { m_barriers.push_back(framebuffer.resolve->get_post_render_barrier()); }
 	if (framebuffer.depth && depth_store_op == vk::AttachmentStoreOp::eStore) { m_barriers.push_back(framebuffer.depth->get_post_render_barrier()); }
 	util::record_barriers(m_command_buffer, m_barriers);
 
 	m_command_buffer = vk::CommandBuffer{};
-	m_rendered_index = m_render_device->get_frame_index();
-	m_render_target = framebuffer.render_image()->render_target();
+	m_rendered_image = framebuffer.render_image();
+	m_render_target = m_rendered_image->render_target();
+	m_render_target.extent = m_extent;
+}
+
+void RenderPass::release_targets() {
+	auto& pooled = m_per_frame->pooled.at(std::size_t(m_render_device->get_frame_index()));
+	if (!pooled.color && !pooled.resolve && !pooled.depth) { return; }
+
+	auto& pool = m_render_device->get_render_target_pool();
+	for (auto const image : {pooled.color, pooled.resolve, pooled.depth}) {
+		if (!image) { continue; }
+		if (m_rendered_image == image) { m_rendered_image = nullptr; }
+		pool.release(*image);
+	}
+	pooled = {};
 }
 
 void RenderPass::bind_graphics_pipeline(vk::Pipeline const pipeline) const {
@@ -215,27 +287,137 @@ auto RenderPass::render_texture_descriptor_info(vk::Sampler const sampler) const
 auto RenderPass::copy_render_texture(vk::Extent2D const custom_extent) const -> std::optional<ColorBitmap> {
 	auto const render_image = get_rendered_image();
 	if (!render_image) { return {}; }
-	return render_image->copy_to_bitmap(custom_extent);
+	// texels beyond the extent are undefined when capacity exceeds it.
+	return static_cast<RenderImage const&>(*render_image).copy_extent_to_bitmap(m_extent, custom_extent);
 }
 
-auto RenderPass::get_rendered_image() const -> klib::Ptr<IRenderImage const> {
-	if (!m_rendered_index) { return {}; }
-	auto const& framebuffer = m_framebuffers.at(std::size_t(*m_rendered_index));
-	return framebuffer.render_image();
+auto RenderPass::get_rendered_image() const -> klib::Ptr<IRenderImage const> { return m_rendered_image; }
+
+auto RenderPass::use_transient_color() const -> bool {
+	return (m_flags & RenderPassFlag::TransientAttachments) == RenderPassFlag::TransientAttachments && m_samples > vk::SampleCountFlagBits::e1;
 }
 
-void RenderPass::prep_for_render(Framebuffer& framebuffer) {
-	if (framebuffer.color) {
-		framebuffer.color->resize(m_extent);
-		if (framebuffer.resolve) { framebuffer.resolve->resize(m_extent); }
+auto RenderPass::use_transient_depth() const -> bool {
+	// depth-only passes expose the depth image as their render target.
+	return (m_flags & RenderPassFlag::TransientAttachments) == RenderPassFlag::TransientAttachments && depth_store_op == vk::AttachmentStoreOp::eDontCare &&
+		   has_color_target();
+}
+
+auto RenderPass::use_pool() const -> bool { return (m_flags & RenderPassFlag::PooledTargets) == RenderPassFlag::PooledTargets; }
+
+auto RenderPass::get_attachments(std::size_t const frame_index) -> Attachments {
+	auto const to_ptr = [](std::optional<RenderImage>& image) -> klib::Ptr<RenderImage> { return image ? &*image : nullptr; };
+	auto& framebuffer = m_framebuffers.at(frame_index);
+	auto ret = m_per_frame->pooled.at(frame_index);
+	if (!ret.color) { ret.color = m_transient_color ? to_ptr(m_transient_color) : to_ptr(framebuffer.color); }
+	if (!ret.resolve) { ret.resolve = to_ptr(framebuffer.resolve); }
+	if (!ret.depth) { ret.depth = m_transient_depth ? to_ptr(m_transient_depth) : to_ptr(framebuffer.depth); }
+	return ret;
+}
+
+void RenderPass::reset_targets(bool const color, bool const depth) {
+	if ((color && has_color_target()) || (depth && has_depth_target())) { m_render_device->get_device().waitIdle(); }
+	m_rendered_image = nullptr;
+	for (auto& framebuffer : m_framebuffers) {
+		if (color) {
+			framebuffer.color.reset();
+			framebuffer.resolve.reset();
+		}
+		if (depth) { framebuffer.depth.reset(); }
+	}
+	// images acquired from the pool are returned when their frames retire.
+	if (color) {
+		m_transient_color.reset();
+		m_pooled_keys.color.reset();
+		m_pooled_keys.resolve.reset();
+	}
+	if (depth) {
+		m_transient_depth.reset();
+		m_pooled_keys.depth.reset();
+	}
+}
+
+void RenderPass::acquire_pooled(std::size_t const frame_index) {
+	auto const matches = [&](klib::Ptr<RenderImage> const image, std::optional<RenderTargetKey> const& key) {
+		if (!image || !key) { return !image && !key; }
+		auto const& info = image->get_create_info();
+		return info.format == key->format && info.samples == key->samples && info.extent == m_capacity;
+	};
+	// rendering again in the same frame: keep the targets already acquired.
+	auto& pooled = m_per_frame->pooled.at(frame_index);
+	if (matches(pooled.color, m_pooled_keys.color) && matches(pooled.resolve, m_pooled_keys.resolve) && matches(pooled.depth, m_pooled_keys.depth)) {
+		return;
 	}
-	if (framebuffer.depth) { framebuffer.depth->resize(m_extent); }
+
+	release_targets();
+	auto& pool = m_render_device->get_render_target_pool();
+	auto const acquire = [&](std::optional<RenderTargetKey> key) -> klib::Ptr<RenderImage> {
+		if (!key) { return nullptr; }
+		key->extent = m_capacity;
+		// all pooled images are created as detail::RenderImage.
+		return &static_cast<RenderImage&>(pool.acquire(*key));
+	};
+	pooled = Attachments{
+		.color = acquire(m_pooled_keys.color),
+		.resolve = acquire(m_pooled_keys.resolve),
+		.depth = acquire(m_pooled_keys.depth),
+	};
 }
 
-auto RenderPass::Framebuffer::render_image() const -> klib::Ptr<IRenderImage const> {
-	if (resolve) { return &*resolve; }
-	if (color) { return &*color; }
-	if (depth) { return &*depth; }
+void RenderPass::update_capacity(vk::Extent2D const previous) {
+	auto const round_up = [bucket = resize_policy.bucket_size](std::uint32_t const value) {
+		return bucket == 0 ? value : (value + bucket - 1) / bucket * bucket;
+	};
+	auto const fit = vk::Extent2D{round_up(m_extent.width), round_up(m_extent.height)};
+	if (!resize_policy.keep_high_water) {
+		m_capacity = fit;
+		return;
+	}
+
+	// the pass may render more than once per frame: shrink_delay counts frames.
+	auto const is_new_frame = std::exchange(m_counted_frame, m_per_frame->frame_count) != m_per_frame->frame_count;
+	if (fit.width > m_capacity.width || fit.height > m_capacity.height) {
+		m_capacity = vk::Extent2D{std::max(fit.width, m_capacity.width), std::max(fit.height, m_capacity.height)};
+		m_stable_frames = 0;
+		return;
+	}
+
+	// shrink to fit once the extent has settled.
+	if (m_extent != previous) {
+		m_stable_frames = 0;
+	} else if (is_new_frame) {
+		++m_stable_frames;
+	}
+	if (m_stable_frames >= resize_policy.shrink_delay) { m_capacity = fit; }
+}
+
+void RenderPass::prep_for_render(Framebuffer& framebuffer) {
+	if (framebuffer.color) { framebuffer.color->resize(m_capacity); }
+	if (framebuffer.resolve) { framebuffer.resolve->resize(m_capacity); }
+	if (framebuffer.depth) { framebuffer.depth->resize(m_capacity); }
+	resize_shared(m_transient_color);
+	resize_shared(m_transient_depth);
+}
+
+void RenderPass::resize_shared(std::optional<RenderImage>& image) {
+	if (!image || image->get_create_info().extent == m_capacity) { return; }
+	// the previous frame may still be rendering to it.
+	auto info = image->get_create_info();
+	info.extent = m_capacity;
+	m_per_frame->retired.at(std::size_t(m_render_device->get_frame_index())).push_back(std::move(*image));
+	image.emplace(m_render_device, info);
+}
+
+void RenderPass::PerFrame::on_next_frame(FrameIndex const frame_index) {
+	++frame_count;
+	pooled.at(std::size_t(frame_index)) = {};
+	retired.at(std::size_t(frame_index)).clear();
+}
+
+auto RenderPass::Attachments::render_image() const -> klib::Ptr<IRenderImage const> {
+	if (resolve) { return resolve.get(); }
+	if (color) { return color.get(); }
+	if (depth) { return depth.get(); }
 	return nullptr;
 }
 
@@ -243,8 +425,9 @@ auto RenderPass::Framebuffer::render_image() const -> klib::Ptr<IRenderImage con
 
 namespace kvf {
 
-auto IRenderPass::create(gsl::not_null<IRenderDevice*> render_device, vk::SampleCountFlagBits const samples) -> std::unique_ptr<IRenderPass> {
-	return std::make_unique<detail::RenderPass>(render_device, samples);
+auto IRenderPass::create(gsl::not_null<IRenderDevice*> render_device, vk::SampleCountFlagBits const samples, RenderPassFlag const flags)
+	-> std::unique_ptr<IRenderPass> {
+	return std::make_unique<detail::RenderPass>(render_device, samples, flags);
 }
 
 auto IRenderPass::to_viewport(UvRect n_rect) const -> vk::Viewport {
@@ -263,4 +446,10 @@ auto IRenderPass::to_scissor(UvRect n_rect) const -> vk::Rect2D {
 	auto const extent = glm::uvec2{rect.size()};
 	return vk::Rect2D{vk::Offset2D{offset.x, offset.y}, vk::Extent2D{extent.x, extent.y}};
 }
+
+auto IRenderPass::get_render_uv() const -> UvRect {
+	auto const extent = util::to_glm_vec(get_extent());
+	auto const capacity = util::to_glm_vec(get_capacity());
+	return UvRect{.lt = {}, .rb = extent / capacity};
+}
 } // namespace kvf
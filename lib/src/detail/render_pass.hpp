@@ -2,26 +2,52 @@
 #include "detail/render_image.hpp"
 #include "klib/ptr.hpp"
 #include "kvf/frame_index.hpp"
+#include "kvf/next_frame_listener.hpp"
 #include "kvf/render_pass.hpp"
+#include "kvf/render_target_pool.hpp"
 #include "kvf/ring.hpp"
+#include <memory>
 
 namespace kvf::detail {
 class RenderPass : public IRenderPass {
   public:
-	static constexpr auto samples_v = vk::SampleCountFlagBits::e1;
-
-	explicit RenderPass(gsl::not_null<IRenderDevice*> render_device, vk::SampleCountFlagBits samples = samples_v);
+	explicit RenderPass(gsl::not_null<IRenderDevice*> render_device, vk::SampleCountFlagBits samples = samples_v, RenderPassFlag flags = flags_v);
 
   private:
-	struct Framebuffer {
+	// attachments in use for a frame: its own, pooled, or the shared transient ones.
+	struct Attachments {
 		[[nodiscard]] auto render_image() const -> klib::Ptr<IRenderImage const>;
 
+		klib::Ptr<RenderImage> color{};
+		klib::Ptr<RenderImage> resolve{};
+		klib::Ptr<RenderImage> depth{};
+	};
+
+	struct Framebuffer {
 		std::optional<RenderImage> color{};
 		std::optional<RenderImage> resolve{};
 		std::optional<RenderImage> depth{};
 	};
 
+	// state reset once per frame (not on every begin_render()), when the frame's resources are reused.
+	struct PerFrame : INextFrameListener {
+		void on_next_frame(FrameIndex frame_index) final;
+
+		// targets acquired from the pool, reclaimed by it at the same point.
+		Ring<Attachments> pooled{};
+		// shared images replaced during the frame.
+		Ring<std::vector<RenderImage>> retired{};
+		std::uint64_t frame_count{};
+	};
+
+	struct PooledKeys {
+		std::optional<RenderTargetKey> color{};
+		std::optional<RenderTargetKey> resolve{};
+		std::optional<RenderTargetKey> depth{};
+	};
+
 	[[nodiscard]] auto get_render_device() const -> IRenderDevice& final { return *m_render_device; }
+	[[nodiscard]] auto get_flags() const -> RenderPassFlag final { return m_flags; }
 
 	void set_color_target(vk::Format format = vk::Format::eUndefined) final;
 	void set_depth_target() final;
@@ -30,21 +56,25 @@ class RenderPass : public IRenderPass {
 
 	[[nodiscard]] auto create_graphics_pipeline(vk::PipelineLayout layout, PipelineState const& state) -> vk::UniquePipeline final;
 
-	[[nodiscard]] auto has_color_target() const -> bool final { return m_framebuffers.front().color.has_value(); }
-	[[nodiscard]] auto has_resolve_target() const -> bool final { return m_framebuffers.front().resolve.has_value(); }
-	[[nodiscard]] auto has_depth_target() const -> bool final { return m_framebuffers.front().depth.has_value(); }
+	[[nodiscard]] auto has_color_target() const -> bool final { return m_transient_color || m_pooled_keys.color || m_framebuffers.front().color; }
+	[[nodiscard]] auto has_resolve_target() const -> bool final { return m_pooled_keys.resolve || m_framebuffers.front().resolve; }
+	[[nodiscard]] auto has_depth_target() const -> bool final { return m_transient_depth || m_pooled_keys.depth || m_framebuffers.front().depth; }
 
 	[[nodiscard]] auto get_color_format() const -> vk::Format final;
 	[[nodiscard]] auto get_depth_format() const -> vk::Format final;
 	[[nodiscard]] auto get_samples() const -> vk::SampleCountFlagBits final { return m_samples; }
 
 	[[nodiscard]] auto get_extent() const -> vk::Extent2D final { return m_extent; }
+	[[nodiscard]] auto get_capacity() const -> vk::Extent2D final { return m_capacity; }
 	[[nodiscard]] auto render_target() const -> RenderTarget const& final { return m_render_target; }
 
 	void begin_render(vk::CommandBuffer command_buffer, vk::Extent2D extent) final;
 	[[nodiscard]] auto get_command_buffer() const -> vk::CommandBuffer final { return m_command_buffer; }
 	auto allocate_sets(std::span<vk::DescriptorSet> out_sets, std::span<vk::DescriptorSetLayout const> sets_layouts) -> bool final;
+	auto push_descriptors(vk::PipelineLayout pipeline_layout, std::uint32_t set, PushSetLayout const& set_layout,
+						  std::span<DescriptorBinding const> bindings) -> bool final;
 	void end_render() final;
+	void release_targets() final;
 
 	void bind_graphics_pipeline(vk::Pipeline pipeline) const final;
 	void bind_graphics_shader(IGraphicsShader const& shader) const final;
@@ -54,18 +84,36 @@ class RenderPass : public IRenderPass {
 
 	[[nodiscard]] auto get_rendered_image() const -> klib::Ptr<IRenderImage const>;
 
+	[[nodiscard]] auto use_transient_color() const -> bool;
+	[[nodiscard]] auto use_transient_depth() const -> bool;
+	[[nodiscard]] auto use_pool() const -> bool;
+	[[nodiscard]] auto get_attachments(std::size_t frame_index) -> Attachments;
+
+	void reset_targets(bool color, bool depth);
+	void update_capacity(vk::Extent2D previous);
 	void prep_for_render(Framebuffer& framebuffer);
+	void acquire_pooled(std::size_t frame_index);
+	void resize_shared(std::optional<RenderImage>& image);
 
 	gsl::not_null<IRenderDevice*> m_render_device;
 	vk::SampleCountFlagBits m_samples{};
+	RenderPassFlag m_flags{};
 
 	Ring<Framebuffer> m_framebuffers{};
+	std::optional<RenderImage> m_transient_color{};
+	std::optional<RenderImage> m_transient_depth{};
+	PooledKeys m_pooled_keys{};
+	std::shared_ptr<PerFrame> m_per_frame{std::make_shared<PerFrame>()};
 
 	vk::CommandBuffer m_command_buffer{};
 	vk::Extent2D m_extent{ImageCreateInfo::min_extent_v};
+	vk::Extent2D m_capacity{ImageCreateInfo::min_extent_v};
+	std::uint32_t m_stable_frames{};
+	std::uint64_t m_counted_frame{};
 
-	std::optional<FrameIndex> m_rendered_index{};
+	klib::Ptr<IRenderImage const> m_rendered_image{};
 	RenderTarget m_render_target{};
 	std::vector<vk::ImageMemoryBarrier2> m_barriers{};
+	std::vector<vk::WriteDescriptorSet> m_writes{};
 };
 } // namespace kvf::detail
@@ -0,0 +1,64 @@
+#include "detail/render_target_pool.hpp"
+#include "kvf/render_device.hpp"
+#include <algorithm>
+
+namespace kvf::detail {
+RenderTargetPool::RenderTargetPool(gsl::not_null<IRenderDevice*> render_device)
+	: m_render_device(render_device), m_frame_index(render_device->get_frame_index()) {}
+
+auto RenderTargetPool::acquire(RenderTargetKey const& key) -> IRenderImage& {
+	// free, or released earlier in this frame (reuse is ordered by the pre-render barriers in the frame's command buffer).
+	auto const is_available = [&](Entry const& entry) {
+		return !entry.acquired && entry.key == key && (!entry.frame || *entry.frame == m_frame_index);
+	};
+	auto it = std::ranges::find_if(m_entries, is_available);
+	if (it == m_entries.end()) {
+		auto const create_info = ImageCreateInfo{
+			.format = key.format,
+			.aspect = key.aspect,
+			.usage = key.usage,
+			.samples = key.samples,
+			.flags = ImageFlag::DedicatedAlloc,
+			.extent = key.extent,
+		};
+		auto image = std::make_unique<RenderImage>(m_render_device, create_info);
+		auto const size = m_render_device->get_device().getImageMemoryRequirements(static_cast<IRenderImage&>(*image).get_image()).size;
+		m_entries.push_back(Entry{.key = key, .image = std::move(image), .size = size});
+		it = m_entries.end() - 1;
+	}
+
+	it->frame = m_frame_index;
+	it->acquired = true;
+	it->last_used = m_frame_count;
+	return *it->image;
+}
+
+void RenderTargetPool::release(IRenderImage const& image) {
+	auto const it = std::ranges::find_if(m_entries, [&image](Entry const& entry) { return entry.image.get() == &image; });
+	if (it == m_entries.end()) { return; }
+	it->acquired = false;
+}
+
+auto RenderTargetPool::get_stats() const -> RenderTargetPoolStats {
+	auto ret = RenderTargetPoolStats{.images = m_entries.size()};
+	for (auto const& entry : m_entries) {
+		if (entry.acquired) { ++ret.in_use; }
+		ret.bytes += std::size_t(entry.size);
+	}
+	return ret;
+}
+
+void RenderTargetPool::on_next_frame(FrameIndex const frame_index) {
+	m_frame_index = frame_index;
+	++m_frame_count;
+
+	// this frame's fence has been waited on: its images are no longer in use.
+	for (auto& entry : m_entries) {
+		if (entry.frame != frame_index) { continue; }
+		entry.frame.reset();
+		entry.acquired = false;
+	}
+
+	std::erase_if(m_entries, [this](Entry const& entry) { return !entry.frame && m_frame_count - entry.last_used > idle_frames_v; });
+}
+} // namespace kvf::detail
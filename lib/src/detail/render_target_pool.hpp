@@ -0,0 +1,39 @@
+#pragma once
+#include "detail/render_image.hpp"
+#include "kvf/frame_index.hpp"
+#include "kvf/next_frame_listener.hpp"
+#include "kvf/render_target_pool.hpp"
+#include <gsl/pointers>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace kvf::detail {
+class RenderTargetPool : public IRenderTargetPool, public INextFrameListener {
+  public:
+	explicit RenderTargetPool(gsl::not_null<IRenderDevice*> render_device);
+
+	[[nodiscard]] auto acquire(RenderTargetKey const& key) -> IRenderImage& final;
+	void release(IRenderImage const& image) final;
+
+	[[nodiscard]] auto get_stats() const -> RenderTargetPoolStats final;
+
+  private:
+	struct Entry {
+		RenderTargetKey key{};
+		std::unique_ptr<RenderImage> image{};
+		vk::DeviceSize size{};
+		// frame that last acquired the image, until that frame's resources are reused.
+		std::optional<FrameIndex> frame{};
+		bool acquired{};
+		std::uint64_t last_used{};
+	};
+
+	void on_next_frame(FrameIndex frame_index) final;
+
+	gsl::not_null<IRenderDevice*> m_render_device;
+	std::vector<Entry> m_entries{};
+	FrameIndex m_frame_index{};
+	std::uint64_t m_frame_count{};
+};
+} // namespace kvf::detail
@@ -17,8 +17,8 @@ namespace {
 }
 } // namespace
 
-RingBufferAllocator::RingBufferAllocator(gsl::not_null<IRenderDevice*> render_device, BufferUsageLayout const& usage_layout)
-	: m_render_device(render_device), m_usage_layout(usage_layout) {
+RingBufferAllocator::RingBufferAllocator(gsl::not_null<IRenderDevice*> render_device, BufferUsageLayout const& usage_layout, std::uint64_t const trim_frames)
+	: m_render_device(render_device), m_usage_layout(usage_layout), m_trim_frames(trim_frames) {
 	KLIB_ASSERT(!m_usage_layout.empty());
 }
 
@@ -31,24 +31,53 @@ auto RingBufferAllocator::allocate_next() -> std::span<FixedUsageBuffer const> {
 		auto const new_capacity = grow_capacity(pool.layouts.size());
 		pool.layouts.reserve(new_capacity);
 		while (pool.layouts.size() < new_capacity) {
-			auto layout = BufferLayout{};
-			layout.reserve(m_usage_layout.size());
-			for (auto const usage : m_usage_layout) { layout.emplace_back(m_render_device, usage, BufferType::Host); }
+			// spare layouts count as used now: otherwise they would be trimmed as soon as their pool is next reset.
+			auto layout = BufferLayout{.last_used = m_frame_count};
+			layout.buffers.reserve(m_usage_layout.size());
+			for (auto const usage : m_usage_layout) { layout.buffers.emplace_back(m_render_device, usage, BufferType::Host, MemoryCategory::RingBuffer); }
 			pool.layouts.push_back(std::move(layout));
 		}
 	}
-	return pool.layouts.at(pool.index++);
+	auto& ret = pool.layouts.at(pool.index++);
+	ret.last_used = m_frame_count;
+	m_high_water = std::max(m_high_water, pool.index);
+	return ret.buffers;
+}
+
+auto RingBufferAllocator::get_stats() const -> RingBufferAllocatorStats {
+	auto ret = RingBufferAllocatorStats{.high_water = m_high_water};
+	for (auto const& pool : m_pools) {
+		for (auto const& layout : pool.layouts) {
+			ret.buffers += layout.buffers.size();
+			for (auto const& buffer : layout.buffers) { ret.bytes_reserved += buffer.get_capacity(); }
+		}
+	}
+	auto const& pool = m_pools.at(std::size_t(m_frame_index));
+	for (std::size_t i = 0; i < pool.index; ++i) {
+		for (auto const& buffer : pool.layouts.at(i).buffers) { ret.bytes_used += buffer.get_size(); }
+	}
+	return ret;
+}
+
+void RingBufferAllocator::trim() {
+	// layouts beyond index have not been handed out since their pool was last reset, so they cannot be in flight.
+	for (auto& pool : m_pools) { pool.layouts.resize(pool.index); }
+	m_high_water = m_pools.at(std::size_t(m_frame_index)).index;
 }
 
 void RingBufferAllocator::on_next_frame(FrameIndex const frame_index) {
-	m_pools.at(std::size_t(frame_index)).index = 0;
+	++m_frame_count;
+	auto& pool = m_pools.at(std::size_t(frame_index));
+	while (!pool.layouts.empty() && pool.layouts.back().last_used + m_trim_frames < m_frame_count) { pool.layouts.pop_back(); }
+	pool.index = 0;
 	m_frame_index = frame_index;
 }
 } // namespace kvf::detail
 
 namespace kvf {
-auto IRingBufferAllocator::create(gsl::not_null<IRenderDevice*> render_device, BufferUsageLayout const& usage_layout) -> std::shared_ptr<IRingBufferAllocator> {
-	auto ret = std::make_shared<detail::RingBufferAllocator>(render_device, usage_layout);
+auto IRingBufferAllocator::create(gsl::not_null<IRenderDevice*> render_device, BufferUsageLayout const& usage_layout, std::uint64_t const trim_frames)
+	-> std::shared_ptr<IRingBufferAllocator> {
+	auto ret = std::make_shared<detail::RingBufferAllocator>(render_device, usage_layout, trim_frames);
 	render_device->attach_next_frame_listener(ret);
 	return ret;
 }
@@ -6,11 +6,15 @@
 namespace kvf::detail {
 class RingBufferAllocator : public IRingBufferAllocator, public INextFrameListener {
   public:
-	explicit RingBufferAllocator(gsl::not_null<IRenderDevice*> render_device, BufferUsageLayout const& usage_layout);
+	explicit RingBufferAllocator(gsl::not_null<IRenderDevice*> render_device, BufferUsageLayout const& usage_layout, std::uint64_t trim_frames);
 
   private:
-	using BufferLayout = std::vector<FixedUsageBuffer>;
+	struct BufferLayout {
+		std::vector<FixedUsageBuffer> buffers{};
+		std::uint64_t last_used{};
+	};
 
+	// layouts are handed out in order, so used ones are always a prefix (and last_used never increases along a pool).
 	struct Pool {
 		std::vector<BufferLayout> layouts{};
 		std::size_t index{};
@@ -20,12 +24,18 @@ class RingBufferAllocator : public IRingBufferAllocator, public INextFrameListen
 
 	[[nodiscard]] auto allocate_next() -> std::span<FixedUsageBuffer const> final;
 
+	[[nodiscard]] auto get_stats() const -> RingBufferAllocatorStats final;
+	void trim() final;
+
 	void on_next_frame(FrameIndex frame_index) final;
 
 	gsl::not_null<IRenderDevice*> m_render_device;
 	BufferUsageLayout m_usage_layout{};
+	std::uint64_t m_trim_frames{};
 
 	FrameIndex m_frame_index{};
+	std::uint64_t m_frame_count{};
+	std::size_t m_high_water{};
 	Ring<Pool> m_pools{};
 };
 } // namespace kvf::detail
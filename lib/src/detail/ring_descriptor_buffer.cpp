@@ -0,0 +1,187 @@
+#include "detail/ring_descriptor_buffer.hpp"
+#include "kvf/render_device.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <bit>
+#include <ranges>
+
+namespace kvf::detail {
+namespace {
+constexpr auto usage_v = vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT;
+
+[[nodiscard]] constexpr auto align_up(vk::DeviceSize const value, vk::DeviceSize const alignment) -> vk::DeviceSize {
+	if (alignment == 0) { return value; }
+	return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+RingDescriptorBuffer::RingDescriptorBuffer(gsl::not_null<IRenderDevice*> render_device, vk::DeviceSize const capacity)
+	: m_render_device(render_device), m_capacity(std::bit_ceil(std::max(capacity, vk::DeviceSize{1024}))) {
+	auto const chain = m_render_device->get_gpu().device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorBufferPropertiesEXT>();
+	m_properties = chain.get<vk::PhysicalDeviceDescriptorBufferPropertiesEXT>();
+	// both buffers are bound with resource and sampler usage.
+	m_can_overflow = std::min({m_properties.maxDescriptorBufferBindings, m_properties.maxResourceDescriptorBufferBindings,
+							   m_properties.maxSamplerDescriptorBufferBindings}) >= 2;
+	for (auto& frame : m_frames) {
+		frame.buffers[0] = create_buffer(m_capacity);
+		// the overflow buffer is bound up front with the frame's own: offsets set before it is used stay valid.
+		if (m_can_overflow) { frame.buffers[1] = create_buffer(m_capacity); }
+	}
+}
+
+auto RingDescriptorBuffer::allocate_next(std::span<DescriptorBufferSet> out_sets, std::span<vk::DescriptorSetLayout const> set_layouts) -> bool {
+	if (set_layouts.empty() || out_sets.size() != set_layouts.size()) { return false; }
+	if (allocate_in(0, out_sets, set_layouts)) { return true; }
+
+	// buffers referenced by commands recorded this frame must stay valid: grow when this frame slot is next reused.
+	auto& frame = get_frame();
+	if (frame.buffers[1]) {
+		if (frame.heads[1] == 0 && m_capacity < 2 * frame.buffers[0]->get_size()) {
+			m_capacity = 2 * frame.buffers[0]->get_size();
+			log.warn("RingDescriptorBuffer: out of space, using overflow buffer, growing to {} bytes", m_capacity);
+		}
+		if (allocate_in(1, out_sets, set_layouts)) { return true; }
+	}
+
+	auto required = vk::DeviceSize{};
+	for (auto const layout : set_layouts) {
+		required += align_up(m_render_device->get_device().getDescriptorSetLayoutSizeEXT(layout), m_properties.descriptorBufferOffsetAlignment);
+	}
+	required = std::bit_ceil(required);
+	auto const total = frame.buffers[0]->get_size() + (frame.buffers[1] ? frame.buffers[1]->get_size() : 0);
+	if (auto const capacity = std::bit_ceil(total + required); capacity > m_capacity) {
+		m_capacity = capacity;
+		log.warn("RingDescriptorBuffer: out of space, growing to {} bytes", m_capacity);
+	}
+	return false;
+}
+
+auto RingDescriptorBuffer::write(DescriptorBufferSet const& set, std::span<DescriptorBinding const> bindings) -> bool {
+	auto const device = m_render_device->get_device();
+	auto const bytes = get_frame().buffers.at(set.buffer)->get_mapped_span().subspan(set.offset);
+	auto const set_size = device.getDescriptorSetLayoutSizeEXT(set.layout);
+	auto ret = true;
+	for (auto const& binding : bindings) {
+		auto const size = get_descriptor_size(binding.type);
+		if (size == 0) {
+			log.warn("RingDescriptorBuffer: unsupported descriptor type: {}", vk::to_string(binding.type));
+			ret = false;
+			continue;
+		}
+		auto const binding_offset = device.getDescriptorSetLayoutBindingOffsetEXT(set.layout, binding.binding);
+		// descriptors beyond the binding's count would overwrite other bindings, or the next set.
+		auto const count = std::max(binding.buffers.size(), binding.images.size());
+		if (binding_offset > set_size || count > (set_size - binding_offset) / size) {
+			log.warn("RingDescriptorBuffer: {} descriptors do not fit in binding {}", count, binding.binding);
+			ret = false;
+			continue;
+		}
+		auto const get_descriptor = [&](vk::DescriptorGetInfoEXT const& dgi, std::size_t const index) {
+			device.getDescriptorEXT(dgi, size, bytes.subspan(binding_offset + (index * size), size).data());
+		};
+
+		for (std::size_t i = 0; i < binding.buffers.size(); ++i) {
+			auto const& info = binding.buffers[i];
+			if (info.range == vk::WholeSize) {
+				log.warn("RingDescriptorBuffer: buffer descriptor range must be explicit");
+				ret = false;
+				continue;
+			}
+			auto const address = device.getBufferAddress(vk::BufferDeviceAddressInfo{info.buffer}) + info.offset;
+			auto const dai = vk::DescriptorAddressInfoEXT{address, info.range};
+			auto data = vk::DescriptorDataEXT{};
+			if (binding.type == vk::DescriptorType::eUniformBuffer) {
+				data.setPUniformBuffer(&dai);
+			} else {
+				data.setPStorageBuffer(&dai);
+			}
+			get_descriptor(vk::DescriptorGetInfoEXT{binding.type, data}, i);
+		}
+
+		for (std::size_t i = 0; i < binding.images.size(); ++i) {
+			auto const& info = binding.images[i];
+			auto data = vk::DescriptorDataEXT{};
+			switch (binding.type) {
+			case vk::DescriptorType::eSampler: data.setPSampler(&info.sampler); break;
+			case vk::DescriptorType::eCombinedImageSampler: data.setPCombinedImageSampler(&info); break;
+			case vk::DescriptorType::eSampledImage: data.setPSampledImage(&info); break;
+			default: data.setPStorageImage(&info); break;
+			}
+			get_descriptor(vk::DescriptorGetInfoEXT{binding.type, data}, i);
+		}
+	}
+	return ret;
+}
+
+void RingDescriptorBuffer::bind_buffers(vk::CommandBuffer const command_buffer) {
+	m_bindings.clear();
+	for (auto const& buffer : get_frame().buffers) {
+		if (buffer) { m_bindings.emplace_back(buffer->get_device_address(), usage_v); }
+	}
+	command_buffer.bindDescriptorBuffersEXT(m_bindings);
+}
+
+void RingDescriptorBuffer::bind(vk::CommandBuffer const command_buffer, vk::PipelineBindPoint const bind_point, vk::PipelineLayout const pipeline_layout,
+								std::uint32_t const first_set, std::span<DescriptorBufferSet const> sets) {
+	if (sets.empty()) { return; }
+	m_buffer_indices.clear();
+	m_offsets.clear();
+	for (auto const& set : sets) {
+		m_buffer_indices.push_back(set.buffer);
+		m_offsets.push_back(set.offset);
+	}
+	command_buffer.setDescriptorBufferOffsetsEXT(bind_point, pipeline_layout, first_set, m_buffer_indices, m_offsets);
+}
+
+auto RingDescriptorBuffer::get_stats() const -> RingDescriptorBufferStats {
+	auto const& frame = m_frames.at(std::size_t(m_frame_index));
+	auto ret = RingDescriptorBufferStats{};
+	for (auto const [buffer, head] : std::views::zip(frame.buffers, frame.heads)) {
+		if (!buffer) { continue; }
+		ret.bytes_reserved += buffer->get_size();
+		ret.bytes_used += head;
+	}
+	return ret;
+}
+
+void RingDescriptorBuffer::on_next_frame(FrameIndex const frame_index) {
+	m_frame_index = frame_index;
+	auto& frame = get_frame();
+	frame.heads = {};
+	for (auto& buffer : frame.buffers) {
+		if (buffer && buffer->get_size() < m_capacity) { buffer->resize(m_capacity); }
+	}
+}
+
+auto RingDescriptorBuffer::allocate_in(std::uint32_t const buffer, std::span<DescriptorBufferSet> out_sets,
+									   std::span<vk::DescriptorSetLayout const> set_layouts) -> bool {
+	auto const device = m_render_device->get_device();
+	auto& frame = get_frame();
+	auto head = frame.heads.at(buffer);
+	for (auto [out, layout] : std::views::zip(out_sets, set_layouts)) {
+		auto const offset = align_up(head, m_properties.descriptorBufferOffsetAlignment);
+		head = offset + device.getDescriptorSetLayoutSizeEXT(layout);
+		out = DescriptorBufferSet{.layout = layout, .offset = offset, .buffer = buffer};
+	}
+	if (head > frame.buffers.at(buffer)->get_size()) { return false; }
+	frame.heads.at(buffer) = head;
+	return true;
+}
+
+auto RingDescriptorBuffer::create_buffer(vk::DeviceSize const size) const -> std::unique_ptr<IRenderBuffer> {
+	auto const buffer_ci = BufferCreateInfo{.usage = usage_v, .type = BufferType::DeviceMapped, .size = size, .category = MemoryCategory::RingBuffer};
+	return IRenderBuffer::create(m_render_device, buffer_ci);
+}
+
+auto RingDescriptorBuffer::get_descriptor_size(vk::DescriptorType const type) const -> std::size_t {
+	switch (type) {
+	case vk::DescriptorType::eSampler: return m_properties.samplerDescriptorSize;
+	case vk::DescriptorType::eCombinedImageSampler: return m_properties.combinedImageSamplerDescriptorSize;
+	case vk::DescriptorType::eSampledImage: return m_properties.sampledImageDescriptorSize;
+	case vk::DescriptorType::eStorageImage: return m_properties.storageImageDescriptorSize;
+	case vk::DescriptorType::eUniformBuffer: return m_properties.uniformBufferDescriptorSize;
+	case vk::DescriptorType::eStorageBuffer: return m_properties.storageBufferDescriptorSize;
+	default: return 0;
+	}
+}
+} // namespace kvf::detail
@@ -0,0 +1,51 @@
+#pragma once
+#include "kvf/next_frame_listener.hpp"
+#include "kvf/render_buffer.hpp"
+#include "kvf/ring.hpp"
+#include "kvf/ring_descriptor_buffer.hpp"
+#include <gsl/pointers>
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace kvf::detail {
+class RingDescriptorBuffer : public IRingDescriptorBuffer, public INextFrameListener {
+  public:
+	explicit RingDescriptorBuffer(gsl::not_null<IRenderDevice*> render_device, vk::DeviceSize capacity);
+
+  private:
+	// index 0: the frame's own buffer, 1: overflow used once it is exhausted (if the device can bind two).
+	struct Frame {
+		std::array<std::unique_ptr<IRenderBuffer>, 2> buffers{};
+		std::array<vk::DeviceSize, 2> heads{};
+	};
+
+	[[nodiscard]] auto allocate_next(std::span<DescriptorBufferSet> out_sets, std::span<vk::DescriptorSetLayout const> set_layouts) -> bool final;
+	auto write(DescriptorBufferSet const& set, std::span<DescriptorBinding const> bindings) -> bool final;
+	void bind_buffers(vk::CommandBuffer command_buffer) final;
+	void bind(vk::CommandBuffer command_buffer, vk::PipelineBindPoint bind_point, vk::PipelineLayout pipeline_layout, std::uint32_t first_set,
+			  std::span<DescriptorBufferSet const> sets) final;
+
+	[[nodiscard]] auto get_stats() const -> RingDescriptorBufferStats final;
+
+	void on_next_frame(FrameIndex frame_index) final;
+
+	[[nodiscard]] auto allocate_in(std::uint32_t buffer, std::span<DescriptorBufferSet> out_sets, std::span<vk::DescriptorSetLayout const> set_layouts)
+		-> bool;
+	[[nodiscard]] auto create_buffer(vk::DeviceSize size) const -> std::unique_ptr<IRenderBuffer>;
+	[[nodiscard]] auto get_descriptor_size(vk::DescriptorType type) const -> std::size_t;
+	[[nodiscard]] auto get_frame() -> Frame& { return m_frames.at(std::size_t(m_frame_index)); }
+
+	gsl::not_null<IRenderDevice*> m_render_device;
+	vk::PhysicalDeviceDescriptorBufferPropertiesEXT m_properties{};
+	vk::DeviceSize m_capacity{};
+	bool m_can_overflow{};
+
+	Ring<Frame> m_frames{};
+	FrameIndex m_frame_index{};
+
+	std::vector<vk::DescriptorBufferBindingInfoEXT> m_bindings{};
+	std::vector<std::uint32_t> m_buffer_indices{};
+	std::vector<vk::DeviceSize> m_offsets{};
+};
+} // namespace kvf::detail
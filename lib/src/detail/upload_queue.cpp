@@ -0,0 +1,308 @@
+#include "detail/upload_queue.hpp"
+#include "detail/render_buffer.hpp"
+#include "detail/render_image.hpp"
+#include "kvf/panic.hpp"
+#include "kvf/render_device.hpp"
+#include "kvf/util.hpp"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace kvf::detail {
+namespace {
+// satisfies bufferOffset requirements of buffer-image copies for all color formats.
+constexpr vk::DeviceSize staging_alignment_v{16};
+
+[[nodiscard]] constexpr auto align_up(vk::DeviceSize const value, vk::DeviceSize const alignment) -> vk::DeviceSize {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+void record_memory_barrier(vk::CommandBuffer const command_buffer, vk::MemoryBarrier2 const& barrier) {
+	auto di = vk::DependencyInfo{};
+	di.setMemoryBarriers(barrier);
+	command_buffer.pipelineBarrier2(di);
+}
+
+[[nodiscard]] auto create_timeline(vk::Device const device) -> vk::UniqueSemaphore {
+	auto stci = vk::SemaphoreTypeCreateInfo{};
+	stci.setSemaphoreType(vk::SemaphoreType::eTimeline).setInitialValue(0);
+	auto sci = vk::SemaphoreCreateInfo{};
+	sci.setPNext(&stci);
+	return device.createSemaphoreUnique(sci);
+}
+
+[[nodiscard]] auto create_command_pool(vk::Device const device, std::uint32_t const queue_family) -> vk::UniqueCommandPool {
+	auto cpci = vk::CommandPoolCreateInfo{};
+	cpci.setQueueFamilyIndex(queue_family).setFlags(vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
+	return device.createCommandPoolUnique(cpci);
+}
+
+[[nodiscard]] auto allocate_command_buffer(vk::Device const device, vk::CommandPool const pool, std::vector<vk::CommandBuffer>& free_list)
+	-> vk::CommandBuffer {
+	auto ret = vk::CommandBuffer{};
+	if (!free_list.empty()) {
+		ret = free_list.back();
+		free_list.pop_back();
+	} else {
+		auto cbai = vk::CommandBufferAllocateInfo{};
+		cbai.setCommandPool(pool).setCommandBufferCount(1);
+		if (device.allocateCommandBuffers(&cbai, &ret) != vk::Result::eSuccess) { throw Panic{"Failed to allocate Vulkan Command Buffer"}; }
+	}
+	ret.begin(vk::CommandBufferBeginInfo{vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+	return ret;
+}
+} // namespace
+
+UploadQueue::UploadQueue(gsl::not_null<IRenderDevice*> render_device)
+	: m_render_device(render_device), m_dedicated_transfer(render_device->has_dedicated_transfer_queue()) {
+	auto const device = m_render_device->get_device();
+	m_timeline = create_timeline(device);
+	m_command_pool = create_command_pool(device, m_render_device->get_queue_family());
+	if (m_dedicated_transfer) {
+		m_transfer_timeline = create_timeline(device);
+		m_transfer_command_pool = create_command_pool(device, m_render_device->get_transfer_queue_family());
+	}
+}
+
+auto UploadQueue::enqueue(IRenderImage& image, std::span<Bitmap const> layers) -> std::optional<UploadToken> {
+	auto lock = std::scoped_lock{m_mutex};
+	// all IRenderImage instances are created via IRenderImage::create().
+	auto& render_image = static_cast<RenderImage&>(image);
+	auto retired = RenderImage::Retired{};
+	if (!render_image.prepare_overwrite(layers, retired)) { return {}; }
+	if (retired.image.get().image) { m_retired.at(std::size_t(m_render_device->get_frame_index())).push_back(std::move(retired)); }
+
+	auto const layer_size = layers.front().bytes.size();
+	auto& batch = begin_batch();
+	auto staging = stage(batch, layers.size() * layer_size);
+	for (auto const& layer : layers) {
+		std::memcpy(staging.bytes.data(), layer.bytes.data(), layer_size);
+		staging.bytes = staging.bytes.subspan(layer_size);
+	}
+
+	// images with existing contents may be in use by the graphics queue, only fresh ones are safe to write from another queue.
+	if (!m_dedicated_transfer || image.get_layout() != vk::ImageLayout::eUndefined) {
+		render_image.record_overwrite(batch.command_buffer, staging.buffer, staging.offset);
+		return UploadToken{batch.value};
+	}
+
+	auto const transfer_cmd = get_transfer_command_buffer(batch);
+	render_image.record_copy(transfer_cmd, staging.buffer, staging.offset);
+
+	auto barrier = render_image.get_ownership_barrier(m_render_device->get_transfer_queue_family(), m_render_device->get_queue_family());
+	barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer).setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+	util::record_barrier(transfer_cmd, barrier); // release
+
+	barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eNone)
+		.setSrcAccessMask(vk::AccessFlagBits2::eNone)
+		.setDstStageMask(vk::PipelineStageFlagBits2::eTransfer)
+		.setDstAccessMask(vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite);
+	util::record_barrier(batch.command_buffer, barrier); // acquire
+
+	render_image.record_finalize(batch.command_buffer, vk::ImageLayout::eShaderReadOnlyOptimal);
+	return UploadToken{batch.value};
+}
+
+auto UploadQueue::enqueue_region(IRenderImage& image, glm::ivec2 const offset, Bitmap const& bitmap, std::uint32_t const layer, std::uint32_t const mip)
+	-> std::optional<UploadToken> {
+	auto lock = std::scoped_lock{m_mutex};
+	auto& render_image = static_cast<RenderImage&>(image);
+	auto const region = RenderImage::Region{.offset = offset, .size = bitmap.size, .layer = layer, .mip = mip};
+	if (!render_image.can_update(region) || bitmap.bytes.size() != std::size_t(bitmap.size.x * bitmap.size.y) * Bitmap::channels_v) { return {}; }
+
+	// existing contents must be preserved: always copied on the graphics queue.
+	auto& batch = begin_batch();
+	auto const staging = stage(batch, bitmap.bytes.size());
+	std::memcpy(staging.bytes.data(), bitmap.bytes.data(), bitmap.bytes.size());
+	render_image.record_update(batch.command_buffer, staging.buffer, staging.offset, region);
+	return UploadToken{batch.value};
+}
+
+auto UploadQueue::enqueue(IRenderBuffer& buffer, std::span<BufferWrite const> writes, vk::DeviceSize const offset) -> std::optional<UploadToken> {
+	auto const total_size = std::accumulate(writes.begin(), writes.end(), 0uz, [](std::size_t i, BufferWrite const& w) { return i + w.size(); });
+	if (buffer.get_size() < offset + total_size) { return {}; }
+	if (total_size == 0) { return UploadToken{}; }
+
+	// host visible: nothing to stage, writes are visible to the next submission.
+	if (auto dst = buffer.get_mapped_span(); !dst.empty()) {
+		dst = dst.subspan(offset);
+		for (auto const write : writes) {
+			if (write.is_empty()) { continue; }
+			std::memcpy(dst.data(), write.data(), write.size());
+			dst = dst.subspan(write.size());
+		}
+		return UploadToken{};
+	}
+
+	if ((buffer.get_usage() & vk::BufferUsageFlagBits::eTransferDst) != vk::BufferUsageFlagBits::eTransferDst) { return {}; }
+
+	// buffers are partially overwritten (existing contents must be preserved): always copied on the graphics queue.
+	auto lock = std::scoped_lock{m_mutex};
+	auto& batch = begin_batch();
+	auto staging = stage(batch, total_size);
+	for (auto const write : writes) {
+		if (write.is_empty()) { continue; }
+		std::memcpy(staging.bytes.data(), write.data(), write.size());
+		staging.bytes = staging.bytes.subspan(write.size());
+	}
+
+	auto const bc = vk::BufferCopy2{staging.offset, offset, total_size};
+	auto cbi = vk::CopyBufferInfo2{};
+	cbi.setSrcBuffer(staging.buffer).setDstBuffer(buffer.get_buffer()).setRegions(bc);
+	batch.command_buffer.copyBuffer2(cbi);
+
+	return UploadToken{batch.value};
+}
+
+auto UploadQueue::flush() -> UploadToken {
+	auto lock = std::scoped_lock{m_mutex};
+	return flush_pending();
+}
+
+auto UploadQueue::is_ready(UploadToken const token) const -> bool {
+	return get_counter_value(m_render_device->get_device(), *m_timeline) >= std::uint64_t(token);
+}
+
+auto UploadQueue::wait(UploadToken const token, std::chrono::nanoseconds const timeout) -> bool {
+	auto const value = std::uint64_t(token);
+	{
+		auto lock = std::scoped_lock{m_mutex};
+		if (m_pending && value >= m_pending->value) { flush_pending(); }
+	}
+	return wait_for(*m_timeline, value, timeout);
+}
+
+void UploadQueue::release_retired(FrameIndex const frame_index) {
+	auto lock = std::scoped_lock{m_mutex};
+	m_retired.at(std::size_t(frame_index)).clear();
+}
+
+void UploadQueue::set_transfer_wait(vk::Semaphore const timeline, std::uint64_t const value) {
+	auto lock = std::scoped_lock{m_mutex};
+	m_transfer_wait = vk::SemaphoreSubmitInfo{timeline, value, vk::PipelineStageFlagBits2::eAllCommands};
+}
+
+auto UploadQueue::get_counter_value(vk::Device const device, vk::Semaphore const timeline) -> std::uint64_t {
+	return device.getSemaphoreCounterValue(timeline);
+}
+
+auto UploadQueue::wait_for(vk::Semaphore const timeline, std::uint64_t const value, std::chrono::nanoseconds const timeout) const -> bool {
+	auto const device = m_render_device->get_device();
+	if (get_counter_value(device, timeline) >= value) { return true; }
+	auto swi = vk::SemaphoreWaitInfo{};
+	swi.setSemaphores(timeline).setValues(value);
+	return device.waitSemaphores(swi, std::uint64_t(timeout.count())) == vk::Result::eSuccess;
+}
+
+auto UploadQueue::begin_batch() -> Batch& {
+	if (m_pending) { return *m_pending; }
+
+	retire();
+
+	auto const command_buffer = allocate_command_buffer(m_render_device->get_device(), *m_command_pool, m_free_command_buffers);
+
+	// targets may still be in use by previously submitted work.
+	auto barrier = vk::MemoryBarrier2{};
+	barrier.setSrcAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+		.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+		.setDstAccessMask(vk::AccessFlagBits2::eTransferWrite)
+		.setDstStageMask(vk::PipelineStageFlagBits2::eTransfer);
+	record_memory_barrier(command_buffer, barrier);
+
+	return m_pending.emplace(Batch{.value = m_next_value++, .command_buffer = command_buffer});
+}
+
+auto UploadQueue::get_transfer_command_buffer(Batch& batch) -> vk::CommandBuffer {
+	if (!batch.transfer_command_buffer) {
+		batch.transfer_command_buffer = allocate_command_buffer(m_render_device->get_device(), *m_transfer_command_pool, m_free_transfer_command_buffers);
+	}
+	return batch.transfer_command_buffer;
+}
+
+auto UploadQueue::stage(Batch& batch, vk::DeviceSize const size) -> Staging {
+	auto const fits = [size](Block const& block) { return align_up(block.used, staging_alignment_v) + size <= block.buffer->get_size(); };
+
+	if (batch.blocks.empty() || !fits(batch.blocks.back())) {
+		auto const it = std::ranges::find_if(m_free_blocks, fits);
+		if (it != m_free_blocks.end()) {
+			batch.blocks.push_back(std::move(*it));
+			m_free_blocks.erase(it);
+		} else {
+			auto const bci = BufferCreateInfo{
+				.usage = vk::BufferUsageFlagBits::eTransferSrc,
+				.type = BufferType::Host,
+				.size = std::max(size, block_size_v),
+				.category = MemoryCategory::Upload,
+			};
+			batch.blocks.push_back(Block{.buffer = std::make_unique<RenderBuffer>(m_render_device, bci)});
+		}
+	}
+
+	auto& block = batch.blocks.back();
+	auto const offset = align_up(block.used, staging_alignment_v);
+	block.used = offset + size;
+	return Staging{.buffer = block.buffer->get_buffer(), .offset = offset, .bytes = block.buffer->get_mapped_span().subspan(offset, size)};
+}
+
+auto UploadQueue::flush_pending() -> UploadToken {
+	if (!m_pending) { return UploadToken{m_next_value - 1}; }
+
+	auto batch = std::move(*m_pending);
+	m_pending.reset();
+	auto const ret = UploadToken{batch.value};
+
+	if (m_dedicated_transfer) {
+		// every batch signals the transfer timeline (even without any commands) to keep its values contiguous.
+		auto const cbsi = vk::CommandBufferSubmitInfo{batch.transfer_command_buffer};
+		auto const sssi = vk::SemaphoreSubmitInfo{*m_transfer_timeline, batch.value, vk::PipelineStageFlagBits2::eAllCommands};
+		auto si = vk::SubmitInfo2{};
+		si.setSignalSemaphoreInfos(sssi);
+		if (m_transfer_wait.semaphore) { si.setWaitSemaphoreInfos(m_transfer_wait); }
+		if (batch.transfer_command_buffer) {
+			batch.transfer_command_buffer.end();
+			si.setCommandBufferInfos(cbsi);
+		}
+		m_render_device->transfer_queue_submit(si);
+	}
+
+	auto barrier = vk::MemoryBarrier2{};
+	barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+		.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
+		.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+		.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+	record_memory_barrier(batch.command_buffer, barrier);
+	batch.command_buffer.end();
+
+	// the graphics half waits on the GPU for its transfers: work submitted after it (eg the frame) is ordered behind it.
+	auto const cbsi = vk::CommandBufferSubmitInfo{batch.command_buffer};
+	auto const wssi = vk::SemaphoreSubmitInfo{*m_transfer_timeline, batch.value, vk::PipelineStageFlagBits2::eAllCommands};
+	auto const sssi = vk::SemaphoreSubmitInfo{*m_timeline, batch.value, vk::PipelineStageFlagBits2::eAllCommands};
+	auto si = vk::SubmitInfo2{};
+	si.setCommandBufferInfos(cbsi).setSignalSemaphoreInfos(sssi);
+	if (m_dedicated_transfer) { si.setWaitSemaphoreInfos(wssi); }
+	m_render_device->queue_submit(si);
+
+	m_in_flight.push_back(std::move(batch));
+	return ret;
+}
+
+void UploadQueue::retire() {
+	auto const completed = get_counter_value(m_render_device->get_device(), *m_timeline);
+	while (!m_in_flight.empty() && m_in_flight.front().value <= completed) {
+		auto& batch = m_in_flight.front();
+		batch.command_buffer.reset();
+		m_free_command_buffers.push_back(batch.command_buffer);
+		if (batch.transfer_command_buffer) {
+			batch.transfer_command_buffer.reset();
+			m_free_transfer_command_buffers.push_back(batch.transfer_command_buffer);
+		}
+		for (auto& block : batch.blocks) {
+			// drop oversized blocks and excess free ones.
+			if (block.buffer->get_size() > block_size_v || m_free_blocks.size() >= max_free_blocks_v) { continue; }
+			block.used = 0;
+			m_free_blocks.push_back(std::move(block));
+		}
+		m_in_flight.pop_front();
+	}
+}
+} // namespace kvf::detail
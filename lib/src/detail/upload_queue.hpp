@@ -0,0 +1,88 @@
+#pragma once
+#include "detail/render_image.hpp"
+#include "kvf/frame_index.hpp"
+#include "kvf/kvf_fwd.hpp"
+#include "kvf/render_buffer.hpp"
+#include "kvf/ring.hpp"
+#include "kvf/upload_queue.hpp"
+#include <deque>
+#include <gsl/pointers>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace kvf::detail {
+class UploadQueue : public IUploadQueue {
+  public:
+	static constexpr vk::DeviceSize block_size_v{16 * 1024 * 1024};
+	static constexpr std::size_t max_free_blocks_v{4};
+
+	explicit UploadQueue(gsl::not_null<IRenderDevice*> render_device);
+
+	auto enqueue(IRenderImage& image, std::span<Bitmap const> layers) -> std::optional<UploadToken> final;
+	auto enqueue_region(IRenderImage& image, glm::ivec2 offset, Bitmap const& bitmap, std::uint32_t layer, std::uint32_t mip)
+		-> std::optional<UploadToken> final;
+	auto enqueue(IRenderBuffer& buffer, std::span<BufferWrite const> writes, vk::DeviceSize offset) -> std::optional<UploadToken> final;
+
+	auto flush() -> UploadToken final;
+
+	[[nodiscard]] auto is_ready(UploadToken token) const -> bool final;
+	auto wait(UploadToken token, std::chrono::nanoseconds timeout) -> bool final;
+
+	/// \brief Destroy images replaced while frame_index was last current (its fence must have been waited on).
+	void release_retired(FrameIndex frame_index);
+	/// \brief Make subsequent submissions to the dedicated transfer queue (if any) wait for timeline to reach value.
+	void set_transfer_wait(vk::Semaphore timeline, std::uint64_t value);
+
+  private:
+	struct Block {
+		std::unique_ptr<IRenderBuffer> buffer{};
+		vk::DeviceSize used{};
+	};
+
+	// Copies into fresh images are recorded on the dedicated transfer queue (if any) and released to the graphics queue,
+	// everything else (acquires, mip maps, buffer copies) is recorded on the graphics queue.
+	struct Batch {
+		std::uint64_t value{};
+		vk::CommandBuffer command_buffer{};
+		vk::CommandBuffer transfer_command_buffer{};
+		std::vector<Block> blocks{};
+	};
+
+	struct Staging {
+		vk::Buffer buffer{};
+		vk::DeviceSize offset{};
+		std::span<std::byte> bytes{};
+	};
+
+	[[nodiscard]] static auto get_counter_value(vk::Device device, vk::Semaphore timeline) -> std::uint64_t;
+	[[nodiscard]] auto wait_for(vk::Semaphore timeline, std::uint64_t value, std::chrono::nanoseconds timeout) const -> bool;
+
+	auto begin_batch() -> Batch&;
+	auto get_transfer_command_buffer(Batch& batch) -> vk::CommandBuffer;
+	auto stage(Batch& batch, vk::DeviceSize size) -> Staging;
+	auto flush_pending() -> UploadToken;
+	void retire();
+
+	gsl::not_null<IRenderDevice*> m_render_device;
+	bool m_dedicated_transfer{};
+
+	vk::UniqueSemaphore m_timeline{};
+	vk::UniqueSemaphore m_transfer_timeline{};
+	// work on the graphics queue (eg defragmentation moves) that transfers must not race.
+	vk::SemaphoreSubmitInfo m_transfer_wait{};
+	vk::UniqueCommandPool m_command_pool{};
+	vk::UniqueCommandPool m_transfer_command_pool{};
+
+	std::optional<Batch> m_pending{};
+	std::deque<Batch> m_in_flight{};
+	std::vector<Block> m_free_blocks{};
+	std::vector<vk::CommandBuffer> m_free_command_buffers{};
+	std::vector<vk::CommandBuffer> m_free_transfer_command_buffers{};
+	Ring<std::vector<RenderImage::Retired>> m_retired{};
+	std::uint64_t m_next_value{1};
+
+	std::mutex m_mutex{};
+};
+} // namespace kvf::detail
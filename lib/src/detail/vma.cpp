@@ -2,28 +2,393 @@
 #include "klib/debug/assert.hpp"
 #include "kvf/panic.hpp"
 #include "kvf/util.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <array>
+#include <utility>
 
 namespace kvf::detail {
 namespace vma {
 namespace {
-auto create_image_impl(VmaAllocator allocator, std::uint32_t const queue_family, ImageCreateInfo const& create_info, bool const for_copy) -> UniqueImage {
-	KLIB_ASSERT((create_info.usage & ImageCreateInfo::implicit_usage_v) == ImageCreateInfo::implicit_usage_v);
+constexpr std::size_t max_releases_v{4096};
+
+[[nodiscard]] auto deduce_category(BufferCreateInfo const& create_info) -> MemoryCategory {
+	if (create_info.category != MemoryCategory::Auto) { return create_info.category; }
+	if (create_info.type == BufferType::Readback) { return MemoryCategory::Staging; }
+	if (create_info.type == BufferType::Host && create_info.usage == vk::BufferUsageFlagBits::eTransferSrc) { return MemoryCategory::Staging; }
+	return MemoryCategory::Buffer;
+}
+
+[[nodiscard]] auto deduce_category(ImageCreateInfo const& create_info, bool const for_copy) -> MemoryCategory {
+	static constexpr auto attachment_usage_v = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment;
+	if (create_info.category != MemoryCategory::Auto) { return create_info.category; }
+	if (for_copy) { return MemoryCategory::Staging; }
+	if (create_info.usage & attachment_usage_v) { return MemoryCategory::RenderTarget; }
+	return MemoryCategory::Texture;
+}
+
+// format list is chained through pNext and queue family indices are referenced: not copyable / movable.
+struct ImageCi {
+	explicit ImageCi(std::uint32_t const queue_family, ImageCreateInfo const& create_info, bool const for_copy) : queue_family(queue_family) {
+		auto const mip_maps = (create_info.flags & ImageFlag::MipMaps) == ImageFlag::MipMaps;
+		image_ci.setExtent({create_info.extent.width, create_info.extent.height, 1})
+			.setFormat(create_info.format)
+			.setUsage(create_info.usage)
+			.setTiling(for_copy ? vk::ImageTiling::eLinear : vk::ImageTiling::eOptimal)
+			.setImageType(vk::ImageType::e2D)
+			.setArrayLayers(create_info.layers)
+			.setMipLevels(mip_maps ? util::compute_mip_levels(create_info.extent) : 1)
+			.setSamples(create_info.samples)
+			.setInitialLayout(vk::ImageLayout::eUndefined)
+			.setQueueFamilyIndices(this->queue_family);
+		// compute mip maps are written through UNORM storage views: the storage usage need only be supported by the UNORM format.
+		view_formats = std::array{create_info.format, util::to_unorm(create_info.format)};
+		format_list.setViewFormats(view_formats);
+		if ((create_info.flags & ImageFlag::ComputeMipMaps) == ImageFlag::ComputeMipMaps && view_formats[0] != view_formats[1]) {
+			image_ci.setFlags(vk::ImageCreateFlagBits::eMutableFormat | vk::ImageCreateFlagBits::eExtendedUsage).setPNext(&format_list);
+		}
+	}
+
+	ImageCi(ImageCi const&) = delete;
+	ImageCi(ImageCi&&) = delete;
+	auto operator=(ImageCi const&) -> ImageCi& = delete;
+	auto operator=(ImageCi&&) -> ImageCi& = delete;
+	~ImageCi() = default;
+
+	std::uint32_t queue_family{};
+	std::array<vk::Format, 2> view_formats{};
+	vk::ImageFormatListCreateInfo format_list{};
+	vk::ImageCreateInfo image_ci{};
+};
+
+[[nodiscard]] auto to_vk_buffer_ci(BufferCreateInfo const& create_info) -> vk::BufferCreateInfo {
+	// every buffer is addressable from shaders (bufferDeviceAddress is core in Vulkan 1.3),
+	// and can be copied out of by defragmentation.
+	static constexpr auto implicit_usage_v = vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eTransferSrc;
+	return vk::BufferCreateInfo{{}, create_info.size, create_info.usage | implicit_usage_v};
+}
+
+[[nodiscard]] auto find_large_bar_heap(VmaAllocator allocator) -> bool {
+	VkPhysicalDeviceMemoryProperties const* properties{};
+	vmaGetMemoryProperties(allocator, &properties);
+	static constexpr auto flags_v =
+		VkMemoryPropertyFlags{VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
+	for (std::uint32_t i = 0; i < properties->memoryTypeCount; ++i) {
+		auto const& type = properties->memoryTypes[i];
+		if ((type.propertyFlags & flags_v) != flags_v) { continue; }
+		if (properties->memoryHeaps[type.heapIndex].size > rebar_min_heap_size_v) { return true; }
+	}
+	return false;
+}
+} // namespace
+
+void Buffer::invalidate() const {
+	if (mapped == nullptr) { return; }
+	vmaInvalidateAllocation(allocator->get(), allocation, 0, VK_WHOLE_SIZE);
+}
+
+void Buffer::Deleter::operator()(Buffer const& buffer) const noexcept { buffer.allocator->destroy(buffer); }
+
+void Image::Deleter::operator()(Image const& image) const noexcept { image.allocator->destroy(image); }
+
+void ImageView::Deleter::operator()(ImageView const& image_view) const noexcept { image_view.allocator->destroy(image_view); }
+
+Allocator::Allocator(vk::Instance const instance, vk::PhysicalDevice const physical_device, vk::Device const device, bool const memory_budget)
+	: m_device(device) {
+	static constexpr auto api_version_v = IRenderDevice::vk_api_version_v;
+	auto allocator_ci = VmaAllocatorCreateInfo{};
+	allocator_ci.instance = instance;
+	allocator_ci.physicalDevice = physical_device;
+	allocator_ci.device = device;
+	allocator_ci.vulkanApiVersion = VK_MAKE_VERSION(api_version_v.major, api_version_v.minor, api_version_v.patch);
+	allocator_ci.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+	if (memory_budget) { allocator_ci.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT; }
+	auto dl = VULKAN_HPP_DEFAULT_DISPATCHER;
+	auto vkFunc = VmaVulkanFunctions{};
+	vkFunc.vkGetInstanceProcAddr = dl.vkGetInstanceProcAddr;
+	vkFunc.vkGetDeviceProcAddr = dl.vkGetDeviceProcAddr;
+	allocator_ci.pVulkanFunctions = &vkFunc;
+	if (vmaCreateAllocator(&allocator_ci, &m_allocator) != VK_SUCCESS) { throw Panic{"Failed to create Vulkan Allocator"}; }
+	m_large_bar_heap = find_large_bar_heap(m_allocator);
+}
+
+Allocator::~Allocator() {
+	for (auto const& pool : m_pools) {
+		if (pool.pool != nullptr) { vmaDestroyPool(m_allocator, pool.pool); }
+	}
+	vmaDestroyAllocator(m_allocator);
+}
+
+auto Allocator::create_buffer(BufferCreateInfo const& create_info) noexcept(false) -> UniqueBuffer {
+	KLIB_ASSERT(create_info.type == BufferType::Host || (create_info.usage & vk::BufferUsageFlagBits::eTransferDst) == vk::BufferUsageFlagBits::eTransferDst);
+	KLIB_ASSERT(create_info.size > 0);
+
+	auto const allocation_ci = to_allocation_ci(create_info);
+	auto const buffer_ci = to_vk_buffer_ci(create_info);
+	auto c_buffer_ci = static_cast<VkBufferCreateInfo>(buffer_ci);
+
+	auto const category = deduce_category(create_info);
+	VmaAllocation allocation{};
+	VkBuffer buffer{};
+	auto allocation_info = VmaAllocationInfo{};
+	auto result = VK_ERROR_OUT_OF_DEVICE_MEMORY;
+	if (auto const pool = find_pool(create_info, category)) {
+		auto pool_allocation_ci = allocation_ci;
+		pool_allocation_ci.pool = pool;
+		result = vmaCreateBuffer(m_allocator, &c_buffer_ci, &pool_allocation_ci, &buffer, &allocation, &allocation_info);
+	}
+	// no pool, or pool exhausted: fall back to the default pools.
+	if (result != VK_SUCCESS) { result = vmaCreateBuffer(m_allocator, &c_buffer_ci, &allocation_ci, &buffer, &allocation, &allocation_info); }
+	if (result != VK_SUCCESS) { throw Panic{"Failed to create Vulkan Buffer"}; }
+	track(allocation, category, allocation_info.size);
+
+	auto memory_flags = VkMemoryPropertyFlags{};
+	vmaGetAllocationMemoryProperties(m_allocator, allocation, &memory_flags);
+	auto placement = BufferPlacement::Host;
+	if ((memory_flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0) {
+		placement = (memory_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0 ? BufferPlacement::DeviceMapped : BufferPlacement::Device;
+	}
+
+	auto const device_address = m_device.getBufferAddress(vk::BufferDeviceAddressInfo{buffer});
+
+	return Buffer{
+		.buffer = buffer,
+		.allocator = this,
+		.allocation = allocation,
+		.mapped = allocation_info.pMappedData,
+		.placement = placement,
+		.device_address = device_address,
+	};
+}
+
+auto Allocator::create_image(std::uint32_t const queue_family, ImageCreateInfo const& create_info) -> UniqueImage {
+	return create_image_impl(queue_family, create_info, false);
+}
+
+auto Allocator::create_image_for_copy(std::uint32_t const queue_family, ImageCreateInfo const& create_info) -> UniqueImage {
+	return create_image_impl(queue_family, create_info, true);
+}
+
+auto Allocator::create_image_view(util::ImageViewCreateInfo const& create_info) -> UniqueImageView {
+	return ImageView{.view = util::create_image_view(m_device, create_info).release(), .allocator = this};
+}
+
+void Allocator::create_pool(MemoryCategory const category, MemoryPoolInfo const& info) {
+	KLIB_ASSERT(category != MemoryCategory::Auto);
+	if (info.algorithm == PoolAlgorithm::None) { return; }
+
+	// memory type is chosen as for any host buffer of category; usage does not affect it for host visible memory.
+	auto const sample_ci = BufferCreateInfo{.usage = vk::BufferUsageFlagBits::eTransferSrc, .type = BufferType::Host, .category = category};
+	auto const buffer_ci = static_cast<VkBufferCreateInfo>(to_vk_buffer_ci(sample_ci));
+	auto const allocation_ci = to_allocation_ci(sample_ci);
+	auto memory_type = std::uint32_t{};
+	if (vmaFindMemoryTypeIndexForBufferInfo(m_allocator, &buffer_ci, &allocation_ci, &memory_type) != VK_SUCCESS) {
+		log.warn("No memory type for {} pool", to_string_view(category));
+		return;
+	}
+
+	auto pool_ci = VmaPoolCreateInfo{};
+	pool_ci.memoryTypeIndex = memory_type;
+	pool_ci.blockSize = info.block_size;
+	pool_ci.maxBlockCount = info.max_blocks;
+	if (info.algorithm == PoolAlgorithm::Linear) { pool_ci.flags |= VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT; }
+	auto pool = VmaPool{};
+	if (vmaCreatePool(m_allocator, &pool_ci, &pool) != VK_SUCCESS) { throw Panic{"Failed to create Vulkan Memory Pool"}; }
+
+	auto& entry = m_pools.at(std::size_t(category));
+	if (entry.pool != nullptr) { vmaDestroyPool(m_allocator, entry.pool); }
+	entry = Pool{.pool = pool, .block_size = info.block_size};
+}
+
+auto Allocator::get_category_stats() const -> std::array<MemoryCategoryStats, memory_category_count_v> {
+	auto lock = std::scoped_lock{m_mutex};
+	return m_stats;
+}
+
+auto Allocator::get_memory_stats() const -> MemoryStats {
+	VkPhysicalDeviceMemoryProperties const* properties{};
+	vmaGetMemoryProperties(m_allocator, &properties);
+	auto budgets = std::array<VmaBudget, VK_MAX_MEMORY_HEAPS>{};
+	vmaGetHeapBudgets(m_allocator, budgets.data());
+
+	auto ret = MemoryStats{.categories = get_category_stats()};
+	ret.heaps.reserve(properties->memoryHeapCount);
+	for (std::uint32_t i = 0; i < properties->memoryHeapCount; ++i) {
+		auto const& heap = properties->memoryHeaps[i];
+		auto const& budget = budgets.at(i);
+		ret.heaps.push_back(MemoryHeapStats{
+			.size = heap.size,
+			.budget = budget.budget,
+			.usage = budget.usage,
+			.block_bytes = budget.statistics.blockBytes,
+			.allocation_bytes = budget.statistics.allocationBytes,
+			.device_local = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+		});
+	}
+	return ret;
+}
+
+void Allocator::record_release(std::uint64_t const handle) {
+	auto lock = std::scoped_lock{m_mutex};
+	record_release_locked(handle);
+}
+
+auto Allocator::get_release_cursor() const -> std::uint64_t {
+	auto lock = std::scoped_lock{m_mutex};
+	return m_release_cursor;
+}
+
+auto Allocator::get_releases(std::uint64_t& cursor, std::vector<std::uint64_t>& out) const -> bool {
+	auto lock = std::scoped_lock{m_mutex};
+	auto const count = m_release_cursor - cursor;
+	cursor = m_release_cursor;
+	if (count > m_releases.size()) { return false; }
+	out.insert(out.end(), m_releases.end() - std::ptrdiff_t(count), m_releases.end());
+	return true;
+}
+
+void Allocator::set_movable(VmaAllocation allocation, Movable* movable) {
+	auto lock = std::scoped_lock{m_mutex};
+	if (movable == nullptr) {
+		m_movables.erase(allocation);
+		return;
+	}
+	m_movables.insert_or_assign(allocation, movable);
+}
+
+void Allocator::begin_moves(vk::CommandBuffer const command_buffer, std::span<VmaDefragmentationMove> moves, std::vector<Retired>& out_retired) {
+	// held while moving: resources cannot be released mid-move.
+	auto lock = std::scoped_lock{m_mutex};
+	for (auto& move : moves) {
+		m_moving.emplace(move.srcAllocation, Orphan{});
+		auto const it = m_movables.find(move.srcAllocation);
+		auto retired = Retired{};
+		if (it == m_movables.end() || !it->second->move_to(command_buffer, move.dstTmpAllocation, retired)) {
+			move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+			continue;
+		}
+		// descriptors must be rewritten to reference the replacements.
+		if (retired.buffer) { record_release_locked(to_word(*retired.buffer)); }
+		if (retired.image_view.get().view) { record_release_locked(to_word(retired.image_view.get().view)); }
+		out_retired.push_back(std::move(retired));
+	}
+}
+
+void Allocator::end_moves(std::span<VmaDefragmentationMove> moves) {
+	auto lock = std::scoped_lock{m_mutex};
+	for (auto& move : moves) {
+		auto const it = m_moving.find(move.srcAllocation);
+		if (it == m_moving.end()) { continue; }
+		auto const& orphan = it->second;
+		if (orphan.released) {
+			if (orphan.buffer) { m_device.destroyBuffer(orphan.buffer); }
+			if (orphan.image) { m_device.destroyImage(orphan.image); }
+			move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+		}
+		m_moving.erase(it);
+	}
+}
+
+void Allocator::destroy(Buffer const& buffer) noexcept {
+	untrack(buffer.allocation, buffer.buffer);
+	if (release(buffer.allocation, buffer.buffer, {})) { return; }
+	vmaDestroyBuffer(m_allocator, buffer.buffer, buffer.allocation);
+}
+
+void Allocator::destroy(Image const& image) noexcept {
+	untrack(image.allocation, {});
+	if (release(image.allocation, {}, image.image)) { return; }
+	vmaDestroyImage(m_allocator, image.image, image.allocation);
+}
+
+void Allocator::destroy(ImageView const& image_view) noexcept {
+	record_release(to_word(image_view.view));
+	m_device.destroyImageView(image_view.view);
+}
+
+void Allocator::record_release_locked(std::uint64_t const handle) {
+	m_releases.push_back(handle);
+	++m_release_cursor;
+	if (m_releases.size() > max_releases_v) { m_releases.pop_front(); }
+}
+
+void Allocator::track(VmaAllocation allocation, MemoryCategory const category, vk::DeviceSize const size) {
+	KLIB_ASSERT(category != MemoryCategory::Auto);
+	// NOLINTNEXTLINE(performance-no-int-to-ptr)
+	vmaSetAllocationUserData(m_allocator, allocation, reinterpret_cast<void*>(std::uintptr_t(category)));
+	auto lock = std::scoped_lock{m_mutex};
+	auto& stats = m_stats.at(std::size_t(category));
+	stats.bytes += size;
+	++stats.allocations;
+}
+
+void Allocator::untrack(VmaAllocation allocation, vk::Buffer const buffer) {
+	auto info = VmaAllocationInfo{};
+	vmaGetAllocationInfo(m_allocator, allocation, &info);
+	auto const category = std::size_t(reinterpret_cast<std::uintptr_t>(info.pUserData));
+	auto lock = std::scoped_lock{m_mutex};
+	// staging buffers are never bound to descriptors, image views record their own releases.
+	if (buffer && category != std::size_t(MemoryCategory::Staging) && category != std::size_t(MemoryCategory::Upload)) { record_release_locked(to_word(buffer)); }
+	if (category >= memory_category_count_v) { return; }
+	auto& stats = m_stats.at(category);
+	stats.bytes -= std::min(stats.bytes, info.size);
+	if (stats.allocations > 0) { --stats.allocations; }
+}
+
+auto Allocator::release(VmaAllocation allocation, vk::Buffer const buffer, vk::Image const image) -> bool {
+	auto lock = std::scoped_lock{m_mutex};
+	m_movables.erase(allocation);
+	auto const it = m_moving.find(allocation);
+	if (it == m_moving.end()) { return false; }
+	it->second = Orphan{.released = true, .buffer = buffer, .image = image};
+	return true;
+}
+
+// custom pool for host buffers of category, if one exists and size fits in its blocks.
+auto Allocator::find_pool(BufferCreateInfo const& create_info, MemoryCategory const category) const -> VmaPool {
+	if (create_info.type != BufferType::Host) { return {}; }
+	auto const& pool = m_pools.at(std::size_t(category));
+	if (pool.block_size > 0 && create_info.size > pool.block_size) { return {}; }
+	return pool.pool;
+}
+
+auto Allocator::to_allocation_ci(BufferCreateInfo const& create_info) const -> VmaAllocationCreateInfo {
+	auto ret = VmaAllocationCreateInfo{};
+	ret.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+	switch (create_info.type) {
+	case BufferType::Device: ret.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE; break;
+	case BufferType::Readback:
+		ret.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+		ret.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		break;
+	case BufferType::DeviceMapped:
+		// mapped spans are handed out and written without flushing: the memory must be coherent.
+		ret.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		ret.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		if (m_large_bar_heap) {
+			ret.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+			ret.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		} else {
+			ret.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+		}
+		break;
+	default:
+		ret.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+		ret.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		break;
+	}
+
+	return ret;
+}
+
+auto Allocator::create_image_impl(std::uint32_t const queue_family, ImageCreateInfo const& create_info, bool const for_copy) -> UniqueImage {
+	auto const transient = (create_info.flags & ImageFlag::Transient) == ImageFlag::Transient;
+	KLIB_ASSERT(transient || (create_info.usage & ImageCreateInfo::implicit_usage_v) == ImageCreateInfo::implicit_usage_v);
 	KLIB_ASSERT(create_info.format != vk::Format::eUndefined);
 	KLIB_ASSERT(create_info.extent.width > 0 && create_info.extent.height > 0);
 
-	auto const mip_maps = (create_info.flags & ImageFlag::MipMaps) == ImageFlag::MipMaps;
-	auto image_ci = vk::ImageCreateInfo{};
-	image_ci.setExtent({create_info.extent.width, create_info.extent.height, 1})
-		.setFormat(create_info.format)
-		.setUsage(create_info.usage)
-		.setTiling(for_copy ? vk::ImageTiling::eLinear : vk::ImageTiling::eOptimal)
-		.setImageType(vk::ImageType::e2D)
-		.setArrayLayers(create_info.layers)
-		.setMipLevels(mip_maps ? util::compute_mip_levels(create_info.extent) : 1)
-		.setSamples(create_info.samples)
-		.setInitialLayout(vk::ImageLayout::eUndefined)
-		.setQueueFamilyIndices(queue_family);
-	auto const vici = static_cast<VkImageCreateInfo>(image_ci);
+	auto const ci = ImageCi{queue_family, create_info, for_copy};
+	auto const vici = static_cast<VkImageCreateInfo>(ci.image_ci);
 	auto allocation_ci = VmaAllocationCreateInfo{};
 	allocation_ci.usage = VMA_MEMORY_USAGE_AUTO;
 	if ((create_info.flags & ImageFlag::DedicatedAlloc) == ImageFlag::DedicatedAlloc) {
@@ -31,52 +396,100 @@ auto create_image_impl(VmaAllocator allocator, std::uint32_t const queue_family,
 		allocation_ci.priority = 1.0f;
 	}
 	if (for_copy) { allocation_ci.flags |= (VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT); }
+	if (transient) { allocation_ci.usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED; }
 
 	VkImage image{};
 	VmaAllocation allocation{};
 	auto allocation_info = VmaAllocationInfo{};
-	if (vmaCreateImage(allocator, &vici, &allocation_ci, &image, &allocation, &allocation_info) != VK_SUCCESS) { throw Panic{"Failed to create Vulkan Image"}; }
+	auto result = vmaCreateImage(m_allocator, &vici, &allocation_ci, &image, &allocation, &allocation_info);
+	if (result != VK_SUCCESS && transient) {
+		// no lazily allocated memory type (typical on desktop GPUs).
+		allocation_ci.usage = VMA_MEMORY_USAGE_AUTO;
+		result = vmaCreateImage(m_allocator, &vici, &allocation_ci, &image, &allocation, &allocation_info);
+	}
+	if (result != VK_SUCCESS) { throw Panic{"Failed to create Vulkan Image"}; }
+	track(allocation, deduce_category(create_info, for_copy), allocation_info.size);
 
-	return Image{.image = image, .allocator = allocator, .allocation = allocation, .mip_levels = image_ci.mipLevels, .mapped = allocation_info.pMappedData};
+	return Image{.image = image, .allocator = this, .allocation = allocation, .mip_levels = ci.image_ci.mipLevels, .mapped = allocation_info.pMappedData};
 }
-} // namespace
-
-void Buffer::Deleter::operator()(Buffer const& buffer) const noexcept { vmaDestroyBuffer(buffer.allocator, buffer.buffer, buffer.allocation); }
-
-void Image::Deleter::operator()(Image const& image) const noexcept { vmaDestroyImage(image.allocator, image.image, image.allocation); }
 } // namespace vma
 
-auto vma::create_buffer(VmaAllocator allocator, BufferCreateInfo const& create_info) noexcept(false) -> UniqueBuffer {
-	KLIB_ASSERT(create_info.type == BufferType::Host || (create_info.usage & vk::BufferUsageFlagBits::eTransferDst) == vk::BufferUsageFlagBits::eTransferDst);
-	KLIB_ASSERT(create_info.size > 0);
+auto vma::move_buffer(vk::CommandBuffer const command_buffer, Buffer& buffer, BufferCreateInfo const& create_info, VmaAllocation dst) -> vk::UniqueBuffer {
+	auto const device = buffer.allocator->get_device();
+	auto ret = vk::UniqueBuffer{buffer.buffer, device};
+	auto new_buffer = device.createBufferUnique(to_vk_buffer_ci(create_info));
+	if (vmaBindBufferMemory(buffer.allocator->get(), dst, *new_buffer) != VK_SUCCESS) { throw Panic{"Failed to bind Vulkan Buffer memory"}; }
 
-	auto allocation_ci = VmaAllocationCreateInfo{};
-	allocation_ci.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
-	if (create_info.type == BufferType::Device) {
-		allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
-	} else {
-		allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
-		allocation_ci.flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
-	}
+	auto const region = vk::BufferCopy2{0, 0, create_info.size};
+	auto cbi = vk::CopyBufferInfo2{};
+	cbi.setSrcBuffer(buffer.buffer).setDstBuffer(*new_buffer).setRegions(region);
+	command_buffer.copyBuffer2(cbi);
 
-	auto const buffer_ci = vk::BufferCreateInfo{{}, create_info.size, create_info.usage};
-	auto c_buffer_ci = static_cast<VkBufferCreateInfo>(buffer_ci);
+	buffer.buffer = new_buffer.release();
+	buffer.device_address = device.getBufferAddress(vk::BufferDeviceAddressInfo{buffer.buffer});
+	return ret;
+}
 
-	VmaAllocation allocation{};
-	VkBuffer buffer{};
-	auto allocation_info = VmaAllocationInfo{};
-	if (vmaCreateBuffer(allocator, &c_buffer_ci, &allocation_ci, &buffer, &allocation, &allocation_info) != VK_SUCCESS) {
-		throw Panic{"Failed to create Vulkan Buffer"};
-	}
+auto vma::move_image(vk::CommandBuffer const command_buffer, Image& image, std::uint32_t const queue_family, ImageCreateInfo const& create_info,
+					 vk::ImageLayout const layout, VmaAllocation dst) -> vk::UniqueImage {
+	auto const device = image.allocator->get_device();
+	auto ret = vk::UniqueImage{image.image, device};
+	auto const ci = ImageCi{queue_family, create_info, false};
+	auto new_image = device.createImageUnique(ci.image_ci);
+	if (vmaBindImageMemory(image.allocator->get(), dst, *new_image) != VK_SUCCESS) { throw Panic{"Failed to bind Vulkan Image memory"}; }
 
-	return Buffer{.buffer = buffer, .allocator = allocator, .allocation = allocation, .mapped = allocation_info.pMappedData};
-}
+	auto const subresource = vk::ImageSubresourceRange{create_info.aspect, 0, image.mip_levels, 0, create_info.layers};
+	auto barriers = std::array<vk::ImageMemoryBarrier2, 2>{};
+	barriers[0]
+		.setImage(image.image)
+		.setSrcQueueFamilyIndex(queue_family)
+		.setDstQueueFamilyIndex(queue_family)
+		.setSubresourceRange(subresource)
+		.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+		.setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+		.setDstStageMask(vk::PipelineStageFlagBits2::eTransfer)
+		.setDstAccessMask(vk::AccessFlagBits2::eTransferRead)
+		.setOldLayout(layout)
+		.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
+	barriers[1]
+		.setImage(*new_image)
+		.setSrcQueueFamilyIndex(queue_family)
+		.setDstQueueFamilyIndex(queue_family)
+		.setSubresourceRange(subresource)
+		.setDstStageMask(vk::PipelineStageFlagBits2::eTransfer)
+		.setDstAccessMask(vk::AccessFlagBits2::eTransferWrite)
+		.setOldLayout(vk::ImageLayout::eUndefined)
+		.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
+	// contents of images in undefined layout need not be preserved.
+	if (layout != vk::ImageLayout::eUndefined) {
+		util::record_barriers(command_buffer, barriers);
 
-auto vma::create_image(VmaAllocator allocator, std::uint32_t const queue_family, ImageCreateInfo const& create_info) -> UniqueImage {
-	return create_image_impl(allocator, queue_family, create_info, false);
-}
+		auto regions = std::vector<vk::ImageCopy2>{};
+		regions.reserve(image.mip_levels);
+		for (std::uint32_t mip = 0; mip < image.mip_levels; ++mip) {
+			auto const layers = vk::ImageSubresourceLayers{create_info.aspect, mip, 0, create_info.layers};
+			auto const extent = vk::Extent3D{std::max(create_info.extent.width >> mip, 1u), std::max(create_info.extent.height >> mip, 1u), 1};
+			regions.push_back(vk::ImageCopy2{layers, {}, layers, {}, extent});
+		}
+		auto cii = vk::CopyImageInfo2{};
+		cii.setSrcImage(image.image)
+			.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal)
+			.setDstImage(*new_image)
+			.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setRegions(regions);
+		command_buffer.copyImage2(cii);
+
+		barriers[1]
+			.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
+			.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+			.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+			.setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setNewLayout(layout);
+		util::record_barrier(command_buffer, barriers[1]);
+	}
 
-auto vma::create_image_for_copy(VmaAllocator allocator, std::uint32_t const queue_family, ImageCreateInfo const& create_info) -> UniqueImage {
-	return create_image_impl(allocator, queue_family, create_info, true);
+	image.image = new_image.release();
+	return ret;
 }
 } // namespace kvf::detail
@@ -1,20 +1,36 @@
 #pragma once
+#include "klib/base_types.hpp"
 #include "klib/unique.hpp"
+#include "kvf/memory_stats.hpp"
 #include "kvf/render_buffer.hpp"
+#include "kvf/render_device.hpp"
 #include "kvf/render_image.hpp"
+#include "kvf/util.hpp"
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
+#include <bit>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace kvf::detail::vma {
+class Allocator;
+
 struct Buffer {
 	struct Deleter;
 
 	auto operator==(Buffer const&) const -> bool = default;
 
+	/// \brief Make device writes visible to the host (no-op for coherent memory).
+	void invalidate() const;
+
 	vk::Buffer buffer{};
-	VmaAllocator allocator{};
+	Allocator* allocator{};
 	VmaAllocation allocation{};
 	void* mapped{};
+	BufferPlacement placement{};
+	vk::DeviceAddress device_address{};
 };
 
 struct Buffer::Deleter {
@@ -23,7 +39,9 @@ struct Buffer::Deleter {
 
 using UniqueBuffer = klib::Unique<Buffer, Buffer::Deleter>;
 
-[[nodiscard]] auto create_buffer(VmaAllocator allocator, BufferCreateInfo const& create_info) noexcept(false) -> UniqueBuffer;
+/// \brief Minimum size of a host visible device local heap for BufferType::DeviceMapped to use it.
+/// Without resizable BAR the heap is typically 256MiB and shared with the driver.
+inline constexpr vk::DeviceSize rebar_min_heap_size_v{256 * 1024 * 1024};
 
 struct Image {
 	struct Deleter;
@@ -31,7 +49,7 @@ struct Image {
 	auto operator==(Image const&) const -> bool = default;
 
 	vk::Image image{};
-	VmaAllocator allocator{};
+	Allocator* allocator{};
 	VmaAllocation allocation{};
 	std::uint32_t mip_levels{};
 	void* mapped{};
@@ -43,6 +61,148 @@ struct Image::Deleter {
 
 using UniqueImage = klib::Unique<Image, Image::Deleter>;
 
-[[nodiscard]] auto create_image(VmaAllocator allocator, std::uint32_t queue_family, ImageCreateInfo const& create_info) noexcept(false) -> UniqueImage;
-[[nodiscard]] auto create_image_for_copy(VmaAllocator allocator, std::uint32_t queue_family, ImageCreateInfo const& create_info) noexcept(false) -> UniqueImage;
+/// \brief View of an image created through an Allocator: its destruction is recorded as a release.
+struct ImageView {
+	struct Deleter;
+
+	auto operator==(ImageView const&) const -> bool = default;
+
+	vk::ImageView view{};
+	Allocator* allocator{};
+};
+
+struct ImageView::Deleter {
+	void operator()(ImageView const& image_view) const noexcept;
+};
+
+using UniqueImageView = klib::Unique<ImageView, ImageView::Deleter>;
+
+template <typename HandleT>
+[[nodiscard]] auto to_word(HandleT const handle) -> std::uint64_t {
+	return std::bit_cast<std::uint64_t>(static_cast<typename HandleT::CType>(handle));
+}
+
+/// \brief Handles replaced by a defragmentation move, to be destroyed once the GPU is done with them.
+struct Retired {
+	vk::UniqueBuffer buffer{};
+	vk::UniqueImage image{};
+	UniqueImageView image_view{};
+	/// \brief Replacement for buffer (if any).
+	vk::Buffer new_buffer{};
+};
+
+/// \brief Resource whose allocation can be relocated by defragmentation.
+class Movable : public klib::Polymorphic {
+  public:
+	/// \brief Bind replacement handles to dst, record copy of contents into command_buffer, and hand previous handles to retired.
+	/// Returning false leaves the allocation in place.
+	virtual auto move_to(vk::CommandBuffer command_buffer, VmaAllocation dst, Retired& retired) -> bool = 0;
+};
+
+/// \brief VMA allocator, and the state tracked for allocations made through it: category totals, custom pools,
+/// relocatable resources and the log of released handles. Owned by the render device.
+class Allocator {
+  public:
+	explicit Allocator(vk::Instance instance, vk::PhysicalDevice physical_device, vk::Device device, bool memory_budget);
+
+	Allocator(Allocator const&) = delete;
+	Allocator(Allocator&&) = delete;
+	auto operator=(Allocator const&) -> Allocator& = delete;
+	auto operator=(Allocator&&) -> Allocator& = delete;
+
+	/// \brief All allocations must have been freed.
+	~Allocator();
+
+	[[nodiscard]] auto get() const -> VmaAllocator { return m_allocator; }
+	[[nodiscard]] auto get_device() const -> vk::Device { return m_device; }
+
+	[[nodiscard]] auto create_buffer(BufferCreateInfo const& create_info) noexcept(false) -> UniqueBuffer;
+	/// \brief Whether there is a host visible, host coherent, device local memory type on a heap larger than rebar_min_heap_size_v.
+	[[nodiscard]] auto has_large_bar_heap() const -> bool { return m_large_bar_heap; }
+
+	[[nodiscard]] auto create_image(std::uint32_t queue_family, ImageCreateInfo const& create_info) noexcept(false) -> UniqueImage;
+	[[nodiscard]] auto create_image_for_copy(std::uint32_t queue_family, ImageCreateInfo const& create_info) noexcept(false) -> UniqueImage;
+	[[nodiscard]] auto create_image_view(util::ImageViewCreateInfo const& create_info) -> UniqueImageView;
+
+	/// \brief Create a custom pool for host buffers of category; subsequent allocations are routed to it when they fit.
+	void create_pool(MemoryCategory category, MemoryPoolInfo const& info);
+	/// \brief Totals of live allocations by category (all buffers / images created through this allocator are tracked).
+	[[nodiscard]] auto get_category_stats() const -> std::array<MemoryCategoryStats, memory_category_count_v>;
+	/// \brief Per-heap budget / usage and category totals.
+	[[nodiscard]] auto get_memory_stats() const -> MemoryStats;
+
+	/// \brief Record handle (of a buffer or image view) as released: descriptors written earlier referencing it are stale,
+	/// and the handle may be recycled once destroyed.
+	void record_release(std::uint64_t handle);
+	/// \brief Position after the latest release, to pass to get_releases().
+	[[nodiscard]] auto get_release_cursor() const -> std::uint64_t;
+	/// \brief Append handles released since cursor (of buffers / image views that can be bound to descriptors: all but staging) to out,
+	/// including handles replaced by moves, and advance cursor.
+	/// \returns false if some of those releases have been dropped from the (bounded) log: treat every handle as released.
+	auto get_releases(std::uint64_t& cursor, std::vector<std::uint64_t>& out) const -> bool;
+
+	/// \brief Register movable as the owner of allocation (nullptr to unregister).
+	void set_movable(VmaAllocation allocation, Movable* movable);
+	/// \brief Record moves of registered resources and mark the rest as VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE.
+	/// Resources of allocations in moves released before end_moves() have their destruction deferred until then.
+	void begin_moves(vk::CommandBuffer command_buffer, std::span<VmaDefragmentationMove> moves, std::vector<Retired>& out_retired);
+	/// \brief Destroy handles of resources released during the pass and mark their moves as VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY.
+	void end_moves(std::span<VmaDefragmentationMove> moves);
+
+	/// \brief Used by the deleters of Buffer / Image / ImageView.
+	void destroy(Buffer const& buffer) noexcept;
+	void destroy(Image const& image) noexcept;
+	void destroy(ImageView const& image_view) noexcept;
+
+  private:
+	using CategoryStats = std::array<MemoryCategoryStats, memory_category_count_v>;
+
+	struct Pool {
+		VmaPool pool{};
+		vk::DeviceSize block_size{};
+	};
+
+	// resource released while its allocation is part of a defragmentation pass.
+	struct Orphan {
+		bool released{};
+		vk::Buffer buffer{};
+		vk::Image image{};
+	};
+
+	void record_release_locked(std::uint64_t handle);
+	void track(VmaAllocation allocation, MemoryCategory category, vk::DeviceSize size);
+	void untrack(VmaAllocation allocation, vk::Buffer buffer);
+	// returns true if destruction must be deferred until the end of the current defragmentation pass.
+	auto release(VmaAllocation allocation, vk::Buffer buffer, vk::Image image) -> bool;
+	[[nodiscard]] auto find_pool(BufferCreateInfo const& create_info, MemoryCategory category) const -> VmaPool;
+	[[nodiscard]] auto to_allocation_ci(BufferCreateInfo const& create_info) const -> VmaAllocationCreateInfo;
+	[[nodiscard]] auto create_image_impl(std::uint32_t queue_family, ImageCreateInfo const& create_info, bool for_copy) -> UniqueImage;
+
+	VmaAllocator m_allocator{};
+	vk::Device m_device{};
+	bool m_large_bar_heap{};
+
+	// each allocation stores its category in its VMA user data.
+	CategoryStats m_stats{};
+	// pools are only created during device initialization.
+	std::array<Pool, memory_category_count_v> m_pools{};
+	std::unordered_map<VmaAllocation, Movable*> m_movables{};
+	std::unordered_map<VmaAllocation, Orphan> m_moving{};
+	// most recent released handles, ending at m_release_cursor.
+	std::deque<std::uint64_t> m_releases{};
+	std::uint64_t m_release_cursor{};
+
+	mutable std::mutex m_mutex{};
+};
+
+/// \brief Replace buffer's handle with one bound to dst and record a copy of its contents.
+[[nodiscard]] auto move_buffer(vk::CommandBuffer command_buffer, Buffer& buffer, BufferCreateInfo const& create_info, VmaAllocation dst) -> vk::UniqueBuffer;
+/// \brief Replace image's handle with one bound to dst, record a copy of all its mips, and transition it to layout.
+[[nodiscard]] auto move_image(vk::CommandBuffer command_buffer, Image& image, std::uint32_t queue_family, ImageCreateInfo const& create_info,
+							  vk::ImageLayout layout, VmaAllocation dst) -> vk::UniqueImage;
 } // namespace kvf::detail::vma
+
+namespace kvf::detail {
+/// \brief Allocator owned by render_device, which must have been created via IRenderDevice::create().
+[[nodiscard]] auto get_vma(IRenderDevice& render_device) -> vma::Allocator&;
+} // namespace kvf::detail
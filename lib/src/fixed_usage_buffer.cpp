@@ -3,8 +3,9 @@
 #include "kvf/render_device.hpp"
 
 namespace kvf {
-FixedUsageBuffer::FixedUsageBuffer(gsl::not_null<IRenderDevice*> render_device, vk::BufferUsageFlags const usage, BufferType const type)
-	: m_usage(usage), m_buffer(IRenderBuffer::create(render_device, BufferCreateInfo{.usage = usage, .type = type})) {}
+FixedUsageBuffer::FixedUsageBuffer(gsl::not_null<IRenderDevice*> render_device, vk::BufferUsageFlags const usage, BufferType const type,
+								   MemoryCategory const category)
+	: m_usage(usage), m_buffer(IRenderBuffer::create(render_device, BufferCreateInfo{.usage = usage, .type = type, .category = category})) {}
 
 void FixedUsageBuffer::write(BufferWrite buffer_write) const {
 	KLIB_ASSERT(m_buffer);
@@ -21,6 +22,16 @@ auto FixedUsageBuffer::get_buffer() const -> vk::Buffer {
 	return m_buffer->get_buffer();
 }
 
+auto FixedUsageBuffer::get_size() const -> vk::DeviceSize {
+	KLIB_ASSERT(m_buffer);
+	return m_buffer->get_size();
+}
+
+auto FixedUsageBuffer::get_capacity() const -> vk::DeviceSize {
+	KLIB_ASSERT(m_buffer);
+	return m_buffer->get_capacity();
+}
+
 auto FixedUsageBuffer::descriptor_info() const -> vk::DescriptorBufferInfo {
 	KLIB_ASSERT(m_buffer);
 	return m_buffer->descriptor_info();
@@ -0,0 +1,165 @@
+#include "kvf/frame_arena.hpp"
+#include "klib/debug/assert.hpp"
+#include "kvf/next_frame_listener.hpp"
+#include "kvf/render_buffer.hpp"
+#include "kvf/render_device.hpp"
+#include "kvf/ring.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+namespace kvf {
+namespace {
+[[nodiscard]] constexpr auto align_up(vk::DeviceSize const value, vk::DeviceSize const alignment) -> vk::DeviceSize {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+class FrameArena : public IFrameArena, public INextFrameListener {
+  public:
+	explicit FrameArena(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info)
+		: m_render_device(render_device), m_usage(create_info.usage), m_block_size(std::max(create_info.block_size, BufferCreateInfo::min_size_v)),
+		  m_trim_frames(create_info.trim_frames) {
+		auto const& limits = m_render_device->get_gpu().properties.limits;
+		m_uniform_alignment = std::max(limits.minUniformBufferOffsetAlignment, vk::DeviceSize{1});
+		m_storage_alignment = std::max(limits.minStorageBufferOffsetAlignment, vk::DeviceSize{1});
+	}
+
+	[[nodiscard]] auto get_render_device() const -> IRenderDevice& final { return *m_render_device; }
+
+	[[nodiscard]] auto allocate(vk::DeviceSize const size, vk::DescriptorType const type) -> BufferSlice final {
+		if (size == 0) { return {}; }
+
+		auto const alignment = get_alignment(type);
+		auto lock = std::scoped_lock{m_mutex};
+		auto& arena = m_arenas.at(std::size_t(m_frame_index));
+		auto const fits = [&](Block const& block) { return align_up(block.used, alignment) + size <= block.buffer->get_size(); };
+
+		if (arena.blocks.empty() || !fits(arena.blocks.back())) {
+			auto const used = get_used(arena);
+			// size the overflow block for the whole frame so far: the next use of this slot coalesces into one buffer of that size.
+			auto const block_size = std::max(std::bit_ceil(used + size), m_block_size);
+			if (!arena.blocks.empty()) { log.debug("FrameArena: overflowed {} bytes, chaining {} byte buffer", used, block_size); }
+			arena.blocks.push_back(create_block(block_size));
+		}
+
+		auto& block = arena.blocks.back();
+		auto const offset = align_up(block.used, alignment);
+		block.used = offset + size;
+		return BufferSlice{
+			.buffer = block.buffer->get_buffer(),
+			.offset = offset,
+			.size = size,
+			.mapped = block.buffer->get_mapped_span().subspan(offset, size),
+			.device_address = block.buffer->get_device_address() + offset,
+		};
+	}
+
+	void trim() final {
+		auto lock = std::scoped_lock{m_mutex};
+		for (auto& arena : m_arenas) { arena.trim = true; }
+	}
+
+  private:
+	struct Block {
+		std::unique_ptr<IRenderBuffer> buffer{};
+		vk::DeviceSize used{};
+	};
+
+	struct Arena {
+		std::vector<Block> blocks{};
+		// peak usage since the last shrink.
+		vk::DeviceSize peak{};
+		std::uint64_t last_trimmed{};
+		bool trim{};
+	};
+
+	[[nodiscard]] static auto get_used(Arena const& arena) -> vk::DeviceSize {
+		return std::accumulate(arena.blocks.begin(), arena.blocks.end(), vk::DeviceSize{}, [](vk::DeviceSize const i, Block const& b) { return i + b.used; });
+	}
+
+	void on_next_frame(FrameIndex const frame_index) final {
+		auto lock = std::scoped_lock{m_mutex};
+		++m_frame_count;
+		m_frame_index = frame_index;
+		auto& arena = m_arenas.at(std::size_t(frame_index));
+		arena.peak = std::max(arena.peak, get_used(arena));
+		if (arena.blocks.size() > 1) {
+			// keep only the last (largest) block, which was sized for the entire frame.
+			arena.blocks.erase(arena.blocks.begin(), arena.blocks.end() - 1);
+		}
+		if (arena.trim || arena.last_trimmed + m_trim_frames < m_frame_count) { shrink(arena); }
+		for (auto& block : arena.blocks) { block.used = 0; }
+	}
+
+	// the fence for this arena's FrameIndex has been waited on: its block is not in flight.
+	void shrink(Arena& arena) const {
+		if (arena.peak == 0) {
+			arena.blocks.clear();
+		} else if (auto const size = std::max(std::bit_ceil(arena.peak), m_block_size); arena.blocks.back().buffer->get_size() > size) {
+			log.debug("FrameArena: shrinking {} byte buffer to {} bytes", arena.blocks.back().buffer->get_size(), size);
+			arena.blocks.back() = create_block(size);
+		}
+		arena.peak = 0;
+		arena.last_trimmed = m_frame_count;
+		arena.trim = false;
+	}
+
+	[[nodiscard]] auto get_alignment(vk::DescriptorType const type) const -> vk::DeviceSize {
+		switch (type) {
+		case vk::DescriptorType::eUniformBuffer:
+		case vk::DescriptorType::eUniformBufferDynamic: return m_uniform_alignment;
+		case vk::DescriptorType::eStorageBuffer:
+		case vk::DescriptorType::eStorageBufferDynamic: return m_storage_alignment;
+		default: return std::max(m_uniform_alignment, m_storage_alignment);
+		}
+	}
+
+	[[nodiscard]] auto create_block(vk::DeviceSize const size) const -> Block {
+		auto const bci = BufferCreateInfo{
+			.usage = m_usage,
+			.type = BufferType::DeviceMapped,
+			.size = size,
+			.category = MemoryCategory::RingBuffer,
+		};
+		auto ret = Block{.buffer = IRenderBuffer::create(m_render_device, bci)};
+		// DeviceMapped memory is host coherent: writes through mapped slices need no flush.
+		KLIB_ASSERT(ret.buffer->get_mapped_ptr() != nullptr);
+		return ret;
+	}
+
+	gsl::not_null<IRenderDevice*> m_render_device;
+	vk::BufferUsageFlags m_usage{};
+	vk::DeviceSize m_block_size{};
+	vk::DeviceSize m_uniform_alignment{};
+	vk::DeviceSize m_storage_alignment{};
+	std::uint64_t m_trim_frames{};
+
+	FrameIndex m_frame_index{};
+	std::uint64_t m_frame_count{};
+	Ring<Arena> m_arenas{};
+	std::mutex m_mutex{};
+};
+} // namespace
+
+auto IFrameArena::create(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info) -> std::shared_ptr<IFrameArena> {
+	auto ret = std::make_shared<FrameArena>(render_device, create_info);
+	render_device->attach_next_frame_listener(ret);
+	return ret;
+}
+
+auto IFrameArena::write(std::span<BufferWrite const> writes, vk::DescriptorType const type) -> BufferSlice {
+	auto const total_size = std::accumulate(writes.begin(), writes.end(), 0uz, [](std::size_t i, BufferWrite const& w) { return i + w.size(); });
+	auto ret = allocate(total_size, type);
+	auto dst = ret.mapped;
+	for (auto const write : writes) {
+		if (write.is_empty()) { continue; }
+		std::memcpy(dst.data(), write.data(), write.size());
+		dst = dst.subspan(write.size());
+	}
+	return ret;
+}
+} // namespace kvf
@@ -0,0 +1,150 @@
+#include "kvf/frame_capture.hpp"
+#include "kvf/render_image.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+
+namespace kvf {
+namespace {
+[[nodiscard]] constexpr auto to_extension(Encoding const encoding) -> std::string_view {
+	switch (encoding) {
+	case Encoding::Jpg: return ".jpg";
+	case Encoding::Tga: return ".tga";
+	default:
+	case Encoding::Png: return ".png";
+	}
+}
+} // namespace
+
+class FrameCapture::Task : public klib::task::Task {
+  public:
+	explicit Task(FrameCapture& capture) : m_capture(capture) {}
+
+	void prepare(Bitmap const& bitmap, std::filesystem::path path) {
+		m_pixels.resize(bitmap.bytes.size());
+		std::memcpy(m_pixels.data(), bitmap.bytes.data(), bitmap.bytes.size());
+		m_size = bitmap.size;
+		m_path = std::move(path);
+	}
+
+	[[nodiscard]] auto get_byte_count() const -> std::size_t { return std::size_t(m_size.x * m_size.y) * Bitmap::channels_v; }
+
+  private:
+	void execute() final {
+		auto const& info = m_capture.m_info;
+		auto const writer = ImageWriter{.bitmap = Bitmap{.bytes = m_pixels, .size = m_size}, .jpg_quality = info.jpg_quality};
+		m_encoded.clear();
+		auto success = writer.write_to(m_encoded, info.encoding);
+		if (success) {
+			auto file = std::ofstream{m_path, std::ios::binary};
+			success = file && file.write(reinterpret_cast<char const*>(m_encoded.data()), std::streamsize(m_encoded.size()));
+		}
+
+		if (success) {
+			++m_capture.m_written;
+		} else {
+			++m_capture.m_failed;
+		}
+		m_capture.release(get_byte_count());
+	}
+
+	FrameCapture& m_capture;
+	std::vector<std::byte> m_pixels{};
+	std::vector<std::byte> m_encoded{};
+	glm::ivec2 m_size{};
+	std::filesystem::path m_path{};
+};
+
+FrameCapture::FrameCapture(gsl::not_null<IRenderDevice*> render_device, CreateInfo create_info)
+	: m_info(std::move(create_info)), m_readback(IReadbackRing::create(render_device)),
+	  m_queue(klib::task::QueueCreateInfo{.thread_count = std::max(m_info.thread_count, klib::task::ThreadCount::Minimum)}) {
+	m_info.interval = std::max(m_info.interval, 1u);
+	auto ec = std::error_code{};
+	std::filesystem::create_directories(m_info.directory, ec);
+	if (ec) { log.warn("FrameCapture: Failed to create directory: {}", m_info.directory.string()); }
+}
+
+FrameCapture::~FrameCapture() { m_queue.drain_and_wait(); }
+
+auto FrameCapture::capture(vk::CommandBuffer const command_buffer, RenderTarget const& target, vk::ImageLayout const layout) -> bool {
+	if (!should_capture()) { return false; }
+
+	auto const size = std::size_t(target.extent.width) * target.extent.height * Bitmap::channels_v;
+	if (!reserve(size)) { return false; }
+
+	auto const index = m_next_index++;
+	auto const on_readback = [this, index, size](Bitmap const& bitmap) { this->on_readback(bitmap, index, size); };
+	if (!m_readback->request(command_buffer, target, layout, on_readback)) {
+		release(size);
+		return false;
+	}
+	return true;
+}
+
+auto FrameCapture::capture(vk::CommandBuffer const command_buffer, IRenderImage const& image) -> bool {
+	if (!should_capture()) { return false; }
+
+	auto const extent = image.get_extent();
+	auto const size = std::size_t(extent.width) * extent.height * Bitmap::channels_v;
+	if (!reserve(size)) { return false; }
+
+	auto const index = m_next_index++;
+	auto const on_readback = [this, index, size](Bitmap const& bitmap) { this->on_readback(bitmap, index, size); };
+	if (!m_readback->request(command_buffer, image, on_readback)) {
+		release(size);
+		return false;
+	}
+	return true;
+}
+
+auto FrameCapture::get_stats() const -> Stats {
+	return Stats{
+		.written = m_written.load(),
+		.dropped = m_dropped.load(),
+		.failed = m_failed.load(),
+		.bytes_in_flight = m_bytes_in_flight.load(),
+	};
+}
+
+void FrameCapture::wait_idle() { m_queue.drain_and_wait(); }
+
+auto FrameCapture::should_capture() -> bool { return m_frame_count++ % m_info.interval == 0; }
+
+auto FrameCapture::reserve(std::size_t const size) -> bool {
+	auto current = m_bytes_in_flight.load();
+	do {
+		if (current + size > m_info.memory_budget) {
+			++m_dropped;
+			return false;
+		}
+	} while (!m_bytes_in_flight.compare_exchange_weak(current, current + size));
+	return true;
+}
+
+void FrameCapture::release(std::size_t const size) { m_bytes_in_flight -= size; }
+
+void FrameCapture::on_readback(Bitmap const& bitmap, std::uint64_t const index, std::size_t const size) {
+	// the frame was never submitted.
+	if (bitmap.bytes.empty()) {
+		++m_dropped;
+		release(size);
+		return;
+	}
+
+	auto const it = std::ranges::find_if(m_tasks, [](std::unique_ptr<Task> const& task) { return !task->is_busy(); });
+	auto* task = it != m_tasks.end() ? it->get() : nullptr;
+	if (task == nullptr) {
+		// every task is bound to at least one in-flight frame, so the budget bounds their count.
+		task = m_tasks.emplace_back(std::make_unique<Task>(*this)).get();
+	}
+
+	auto filename = std::format("{}{:06}{}", m_info.prefix, index, to_extension(m_info.encoding));
+	task->prepare(bitmap, m_info.directory / filename);
+	if (!m_queue.enqueue(*task)) {
+		++m_dropped;
+		release(task->get_byte_count());
+	}
+}
+} // namespace kvf
@@ -0,0 +1,322 @@
+#include "kvf/geometry_arena.hpp"
+#include "klib/debug/assert.hpp"
+#include "klib/unique.hpp"
+#include "kvf/constants.hpp"
+#include "kvf/next_frame_listener.hpp"
+#include "kvf/panic.hpp"
+#include "kvf/render_buffer.hpp"
+#include "kvf/render_device.hpp"
+#include "kvf/scratch_command_buffer.hpp"
+#include "log.hpp"
+#include <vk_mem_alloc.h>
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace kvf {
+namespace {
+constexpr auto index_size_v = vk::DeviceSize{sizeof(std::uint32_t)};
+// vertex offsets are passed to drawIndexed() as int32_t.
+constexpr auto max_elements_v = std::uint64_t{std::numeric_limits<std::int32_t>::max()};
+
+struct VirtualBlockDeleter {
+	void operator()(VmaVirtualBlock block) const noexcept {
+		vmaClearVirtualBlock(block);
+		vmaDestroyVirtualBlock(block);
+	}
+};
+
+using UniqueVirtualBlock = klib::Unique<VmaVirtualBlock, VirtualBlockDeleter>;
+
+[[nodiscard]] auto create_virtual_block(std::uint32_t const size) -> UniqueVirtualBlock {
+	auto vbci = VmaVirtualBlockCreateInfo{};
+	vbci.size = size; // in elements, not bytes.
+	VmaVirtualBlock ret{};
+	if (vmaCreateVirtualBlock(&vbci, &ret) != VK_SUCCESS) { throw Panic{"Failed to create VMA Virtual Block"}; }
+	return ret;
+}
+
+struct Allocation {
+	VmaVirtualAllocation handle{};
+	std::uint32_t offset{};
+	std::uint32_t count{};
+};
+
+[[nodiscard]] auto virtual_allocate(VmaVirtualBlock const block, std::uint32_t const count) -> std::optional<Allocation> {
+	if (count == 0) { return Allocation{}; }
+	auto vaci = VmaVirtualAllocationCreateInfo{};
+	vaci.size = count;
+	auto ret = Allocation{.count = count};
+	auto offset = VkDeviceSize{};
+	if (vmaVirtualAllocate(block, &vaci, &ret.handle, &offset) != VK_SUCCESS) { return {}; }
+	ret.offset = std::uint32_t(offset);
+	return ret;
+}
+
+void virtual_free(VmaVirtualBlock const block, Allocation const& allocation) {
+	if (allocation.handle == VK_NULL_HANDLE) { return; }
+	vmaVirtualFree(block, allocation.handle);
+}
+
+class GeometryArena : public IGeometryArena, public INextFrameListener {
+  public:
+	explicit GeometryArena(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info)
+		: m_render_device(render_device), m_vertex_stride(create_info.vertex_stride) {
+		KLIB_ASSERT(m_vertex_stride > 0);
+		m_max_buffer_size = render_device->get_gpu()
+								.device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceMaintenance4Properties>()
+								.get<vk::PhysicalDeviceMaintenance4Properties>()
+								.maxBufferSize;
+		m_storage = create_storage(std::max(create_info.vertex_capacity, 1u), std::max(create_info.index_capacity, 1u));
+	}
+
+	[[nodiscard]] auto get_render_device() const -> IRenderDevice& final { return *m_render_device; }
+
+	[[nodiscard]] auto upload(BufferWrite const vertices, std::span<std::uint32_t const> indices) -> std::optional<MeshId> final {
+		if (vertices.is_empty() || vertices.size() % m_vertex_stride != 0) { return {}; }
+		if (vertices.size() / m_vertex_stride > max_elements_v || indices.size() > max_elements_v) { return {}; }
+		auto const vertex_count = std::uint32_t(vertices.size() / m_vertex_stride);
+		auto const index_count = std::uint32_t(indices.size());
+
+		auto mesh = allocate(vertex_count, index_count);
+		if (!mesh) {
+			if (!grow(vertex_count, index_count)) { return {}; }
+			mesh = allocate(vertex_count, index_count);
+			if (!mesh) { return {}; }
+		}
+
+		auto& upload_queue = m_render_device->get_upload_queue();
+		auto& buffer = *m_storage.buffer;
+		auto const vertex_token = upload_queue.enqueue(buffer, vertices, vk::DeviceSize{mesh->vertices.offset} * m_vertex_stride);
+		auto index_token = std::optional<UploadToken>{};
+		if (!indices.empty()) { index_token = upload_queue.enqueue(buffer, indices, get_index_offset() + mesh->indices.offset * index_size_v); }
+		KLIB_ASSERT(vertex_token && (indices.empty() || index_token));
+		mesh->token = std::max(*vertex_token, index_token.value_or(UploadToken{}));
+		mesh->frame = m_frame_count;
+
+		auto const ret = MeshId{m_next_id++};
+		m_meshes.emplace(ret, *mesh);
+		return ret;
+	}
+
+	void free(MeshId const id) final {
+		auto const it = m_meshes.find(id);
+		if (it == m_meshes.end()) { return; }
+		m_freed.push_back(Freed{.frame = m_frame_count, .mesh = it->second});
+		m_meshes.erase(it);
+	}
+
+	void compact() final { rebuild(m_storage.vertex_capacity, m_storage.index_capacity); }
+
+	[[nodiscard]] auto get_range(MeshId const id) const -> std::optional<MeshRange> final {
+		auto const it = m_meshes.find(id);
+		if (it == m_meshes.end()) { return {}; }
+		auto const& mesh = it->second;
+		return MeshRange{
+			.vertex_offset = std::int32_t(mesh.vertices.offset),
+			.vertex_count = mesh.vertices.count,
+			.first_index = mesh.indices.offset,
+			.index_count = mesh.indices.count,
+		};
+	}
+
+	[[nodiscard]] auto get_token(MeshId const id) const -> UploadToken final {
+		auto const it = m_meshes.find(id);
+		if (it == m_meshes.end()) { return {}; }
+		return it->second.token;
+	}
+
+	[[nodiscard]] auto is_drawable(MeshId const id) const -> bool final {
+		auto const it = m_meshes.find(id);
+		if (it == m_meshes.end()) { return false; }
+		// uploads enqueued during an earlier frame are submitted before this frame's command buffer.
+		auto const& mesh = it->second;
+		return mesh.frame < m_frame_count || m_render_device->get_upload_queue().is_ready(mesh.token);
+	}
+
+	[[nodiscard]] auto get_stats() const -> GeometryArenaStats final {
+		auto ret = GeometryArenaStats{
+			.meshes = m_meshes.size(),
+			.vertex_capacity = m_storage.vertex_capacity,
+			.index_capacity = m_storage.index_capacity,
+		};
+		for (auto const& [_, mesh] : m_meshes) {
+			ret.vertices_used += mesh.vertices.count;
+			ret.indices_used += mesh.indices.count;
+		}
+		return ret;
+	}
+
+	[[nodiscard]] auto get_buffer() const -> vk::Buffer final { return m_storage.buffer->get_buffer(); }
+	[[nodiscard]] auto get_index_offset() const -> vk::DeviceSize final { return m_storage.index_offset; }
+
+  private:
+	struct Mesh {
+		Allocation vertices{};
+		Allocation indices{};
+		UploadToken token{};
+		std::uint64_t frame{};
+	};
+
+	struct Freed {
+		std::uint64_t frame{};
+		Mesh mesh{};
+	};
+
+	struct Storage {
+		std::unique_ptr<IRenderBuffer> buffer{};
+		UniqueVirtualBlock vertex_block{};
+		UniqueVirtualBlock index_block{};
+		std::uint32_t vertex_capacity{};
+		std::uint32_t index_capacity{};
+		vk::DeviceSize index_offset{};
+	};
+
+	struct Retired {
+		std::uint64_t frame{};
+		std::unique_ptr<IRenderBuffer> buffer{};
+	};
+
+	void on_next_frame(FrameIndex /*frame_index*/) final {
+		++m_frame_count;
+		// ranges may be reused by uploads recorded from now on: wait as long as for retired buffers.
+		while (!m_freed.empty() && m_freed.front().frame + resource_buffering_v + 1 <= m_frame_count) {
+			virtual_free(m_storage.vertex_block.get(), m_freed.front().mesh.vertices);
+			virtual_free(m_storage.index_block.get(), m_freed.front().mesh.indices);
+			m_freed.pop_front();
+		}
+		while (!m_retired.empty() && m_retired.front().frame + resource_buffering_v + 1 <= m_frame_count) { m_retired.pop_front(); }
+	}
+
+	[[nodiscard]] auto create_storage(std::uint32_t const vertex_capacity, std::uint32_t const index_capacity) const -> Storage {
+		auto ret = Storage{
+			.vertex_block = create_virtual_block(vertex_capacity),
+			.index_block = create_virtual_block(index_capacity),
+			.vertex_capacity = vertex_capacity,
+			.index_capacity = index_capacity,
+		};
+		ret.index_offset = get_buffer_size(vertex_capacity, 0);
+		auto const bci = BufferCreateInfo{
+			.usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferSrc |
+					 vk::BufferUsageFlagBits::eTransferDst,
+			.type = BufferType::Device,
+			.size = get_buffer_size(vertex_capacity, index_capacity),
+		};
+		ret.buffer = IRenderBuffer::create(m_render_device, bci);
+		return ret;
+	}
+
+	[[nodiscard]] auto allocate(std::uint32_t const vertex_count, std::uint32_t const index_count) -> std::optional<Mesh> {
+		auto const vertices = virtual_allocate(m_storage.vertex_block.get(), vertex_count);
+		if (!vertices) { return {}; }
+		auto const indices = virtual_allocate(m_storage.index_block.get(), index_count);
+		if (!indices) {
+			virtual_free(m_storage.vertex_block.get(), *vertices);
+			return {};
+		}
+		return Mesh{.vertices = *vertices, .indices = *indices};
+	}
+
+	[[nodiscard]] auto get_buffer_size(std::uint64_t const vertex_capacity, std::uint64_t const index_capacity) const -> vk::DeviceSize {
+		auto const vertex_bytes = vertex_capacity * m_vertex_stride;
+		return (vertex_bytes + index_size_v - 1) / index_size_v * index_size_v + index_capacity * index_size_v;
+	}
+
+	// returns false (leaving storage as is) if the required capacity exceeds the element or buffer size limits.
+	auto grow(std::uint32_t const vertex_count, std::uint32_t const index_count) -> bool {
+		auto const stats = get_stats();
+		auto const needed_vertices = std::uint64_t{stats.vertices_used} + vertex_count;
+		auto const needed_indices = std::uint64_t{stats.indices_used} + index_count;
+		if (needed_vertices > max_elements_v || needed_indices > max_elements_v || get_buffer_size(needed_vertices, needed_indices) > m_max_buffer_size) {
+			log.warn("GeometryArena: cannot grow to {} vertices, {} indices", needed_vertices, needed_indices);
+			return false;
+		}
+		auto const grow_to = [](std::uint64_t const capacity, std::uint64_t const needed) {
+			auto const target = std::min(2 * needed, max_elements_v);
+			auto ret = std::max(capacity, std::uint64_t{1});
+			while (ret < target) { ret *= 2; }
+			return std::min(ret, max_elements_v);
+		};
+		// compacting may already be enough, but doubling keeps repeated uploads from rebuilding every time.
+		auto vertex_capacity = grow_to(m_storage.vertex_capacity, needed_vertices);
+		auto index_capacity = grow_to(m_storage.index_capacity, needed_indices);
+		if (get_buffer_size(vertex_capacity, index_capacity) > m_max_buffer_size) {
+			vertex_capacity = needed_vertices;
+			index_capacity = needed_indices;
+		}
+		log.debug("GeometryArena: growing to {} vertices, {} indices", vertex_capacity, index_capacity);
+		rebuild(std::uint32_t(vertex_capacity), std::uint32_t(index_capacity));
+		return true;
+	}
+
+	void rebuild(std::uint32_t const vertex_capacity, std::uint32_t const index_capacity) {
+		// the copy reads the old buffer: all uploads into it must have completed.
+		auto& upload_queue = m_render_device->get_upload_queue();
+		if (!upload_queue.wait(upload_queue.flush())) { throw Panic{"Failed to wait for GeometryArena uploads"}; }
+
+		// freed meshes are dropped, but frames in flight may still read them from the old buffer.
+		m_freed.clear();
+		auto storage = create_storage(vertex_capacity, index_capacity);
+		auto regions = std::vector<vk::BufferCopy2>{};
+		regions.reserve(2 * m_meshes.size());
+		for (auto& [_, mesh] : m_meshes) {
+			auto const vertices = virtual_allocate(storage.vertex_block.get(), mesh.vertices.count);
+			auto const indices = virtual_allocate(storage.index_block.get(), mesh.indices.count);
+			KLIB_ASSERT(vertices && indices);
+			regions.emplace_back(vk::DeviceSize{mesh.vertices.offset} * m_vertex_stride, vk::DeviceSize{vertices->offset} * m_vertex_stride,
+								 vk::DeviceSize{mesh.vertices.count} * m_vertex_stride);
+			if (mesh.indices.count > 0) {
+				regions.emplace_back(m_storage.index_offset + mesh.indices.offset * index_size_v, storage.index_offset + indices->offset * index_size_v,
+									 mesh.indices.count * index_size_v);
+			}
+			mesh.vertices = *vertices;
+			mesh.indices = *indices;
+			mesh.token = {};
+		}
+
+		if (!regions.empty()) {
+			auto cbi = vk::CopyBufferInfo2{};
+			cbi.setSrcBuffer(m_storage.buffer->get_buffer()).setDstBuffer(storage.buffer->get_buffer()).setRegions(regions);
+			auto cmd = ScratchCommandBuffer{m_render_device};
+			cmd.get().copyBuffer2(cbi);
+			if (!cmd.submit_and_wait()) { throw Panic{"Failed to copy GeometryArena buffer"}; }
+		}
+
+		m_retired.push_back(Retired{.frame = m_frame_count, .buffer = std::move(m_storage.buffer)});
+		m_storage = std::move(storage);
+	}
+
+	gsl::not_null<IRenderDevice*> m_render_device;
+	std::uint32_t m_vertex_stride{};
+	vk::DeviceSize m_max_buffer_size{};
+
+	Storage m_storage{};
+	std::unordered_map<MeshId, Mesh> m_meshes{};
+	std::deque<Freed> m_freed{};
+	std::deque<Retired> m_retired{};
+	std::uint64_t m_next_id{1};
+	std::uint64_t m_frame_count{};
+};
+} // namespace
+
+auto IGeometryArena::create(gsl::not_null<IRenderDevice*> render_device, CreateInfo const& create_info) -> std::shared_ptr<IGeometryArena> {
+	auto ret = std::make_shared<GeometryArena>(render_device, create_info);
+	render_device->attach_next_frame_listener(ret);
+	return ret;
+}
+
+void IGeometryArena::bind(vk::CommandBuffer const command_buffer, std::uint32_t const binding) const {
+	command_buffer.bindVertexBuffers(binding, get_buffer(), vk::DeviceSize{});
+	command_buffer.bindIndexBuffer(get_buffer(), get_index_offset(), vk::IndexType::eUint32);
+}
+
+auto IGeometryArena::draw(vk::CommandBuffer const command_buffer, MeshId const id, std::uint32_t const instance_count,
+						  std::uint32_t const first_instance) const -> bool {
+	auto const range = get_range(id);
+	if (!range || range->index_count == 0 || !is_drawable(id)) { return false; }
+	command_buffer.drawIndexed(range->index_count, instance_count, range->first_index, range->vertex_offset, first_instance);
+	return true;
+}
+} // namespace kvf
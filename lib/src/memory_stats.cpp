@@ -0,0 +1,59 @@
+#include "kvf/memory_stats.hpp"
+#include <imgui.h>
+
+namespace kvf {
+namespace {
+[[nodiscard]] auto to_mib(vk::DeviceSize const bytes) -> float { return float(bytes) / (1024.0f * 1024.0f); }
+} // namespace
+
+void draw_memory_stats(MemoryStats const& stats) {
+	ImGui::Text("VK_EXT_memory_budget: %s", stats.memory_budget_ext ? "enabled" : "unavailable");
+
+	static constexpr auto table_flags_v = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+	if (ImGui::BeginTable("heaps", 5, table_flags_v)) {
+		ImGui::TableSetupColumn("Heap");
+		ImGui::TableSetupColumn("Usage (MiB)");
+		ImGui::TableSetupColumn("Budget (MiB)");
+		ImGui::TableSetupColumn("Allocated (MiB)");
+		ImGui::TableSetupColumn("Size (MiB)");
+		ImGui::TableHeadersRow();
+		for (std::size_t i = 0; i < stats.heaps.size(); ++i) {
+			auto const& heap = stats.heaps[i];
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text("%zu%s", i, heap.device_local ? " (device)" : "");
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", to_mib(heap.usage));
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", to_mib(heap.budget));
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f / %.1f", to_mib(heap.allocation_bytes), to_mib(heap.block_bytes));
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", to_mib(heap.size));
+			if (heap.budget > 0) {
+				ImGui::ProgressBar(float(heap.usage) / float(heap.budget), {-1.0f, 0.0f}, "");
+			}
+		}
+		ImGui::EndTable();
+	}
+
+	if (ImGui::BeginTable("categories", 3, table_flags_v)) {
+		ImGui::TableSetupColumn("Category");
+		ImGui::TableSetupColumn("Allocations");
+		ImGui::TableSetupColumn("MiB");
+		ImGui::TableHeadersRow();
+		for (std::size_t i = 0; i < stats.categories.size(); ++i) {
+			auto const& category = stats.categories.at(i);
+			auto const name = to_string_view(MemoryCategory(i));
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(name.data(), name.data() + name.size());
+			ImGui::TableNextColumn();
+			ImGui::Text("%zu", category.allocations);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", to_mib(category.bytes));
+		}
+		ImGui::EndTable();
+	}
+}
+} // namespace kvf
@@ -0,0 +1,202 @@
+#include "kvf/mip_generator.hpp"
+#include "detail/render_image.hpp"
+#include "kvf/constants.hpp"
+#include "kvf/next_frame_listener.hpp"
+#include "kvf/panic.hpp"
+#include "kvf/render_device.hpp"
+#include "kvf/util.hpp"
+#include <glm/vec2.hpp>
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace kvf {
+namespace {
+constexpr std::uint32_t group_size_v{64};
+
+struct Params {
+	glm::ivec2 base_size{};
+	std::int32_t mip_count{};
+	std::int32_t filter{};
+	std::int32_t srgb{};
+};
+
+class MipGenerator : public IMipGenerator, public INextFrameListener {
+  public:
+	explicit MipGenerator(gsl::not_null<IRenderDevice*> render_device, std::span<std::uint32_t const> const spir_v) : m_render_device(render_device) {
+		auto const device = m_render_device->get_device();
+
+		auto const bindings = std::array{
+			vk::DescriptorSetLayoutBinding{0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute},
+			vk::DescriptorSetLayoutBinding{1, vk::DescriptorType::eStorageImage, mips_per_dispatch_v, vk::ShaderStageFlagBits::eCompute},
+		};
+		auto dslci = vk::DescriptorSetLayoutCreateInfo{};
+		dslci.setBindings(bindings);
+		m_set_layout = device.createDescriptorSetLayoutUnique(dslci);
+
+		auto const pcr = vk::PushConstantRange{vk::ShaderStageFlagBits::eCompute, 0, sizeof(Params)};
+		auto plci = vk::PipelineLayoutCreateInfo{};
+		plci.setSetLayouts(*m_set_layout).setPushConstantRanges(pcr);
+		m_pipeline_layout = device.createPipelineLayoutUnique(plci);
+
+		auto smci = vk::ShaderModuleCreateInfo{};
+		smci.setCode(spir_v);
+		auto const shader_module = device.createShaderModuleUnique(smci);
+		auto cpci = vk::ComputePipelineCreateInfo{};
+		cpci.setLayout(*m_pipeline_layout).setStage({{}, vk::ShaderStageFlagBits::eCompute, *shader_module, "main"});
+		m_pipeline = device.createComputePipelineUnique({}, cpci).value;
+
+		m_sampler = m_render_device->create_sampler(util::create_sampler_ci(vk::SamplerAddressMode::eClampToEdge, vk::Filter::eNearest));
+
+		auto const features = m_render_device->get_gpu().device.getFormatProperties(vk::Format::eR8G8B8A8Unorm).optimalTilingFeatures;
+		m_storage_supported = (features & vk::FormatFeatureFlagBits::eStorageImage) == vk::FormatFeatureFlagBits::eStorageImage;
+	}
+
+	[[nodiscard]] auto is_supported(IRenderImage const& image) const -> bool final {
+		if (!m_storage_supported || image.get_mip_levels() < 2 || image.get_samples() != vk::SampleCountFlagBits::e1) { return false; }
+		auto const format = image.get_format();
+		if (format != vk::Format::eR8G8B8A8Srgb && format != vk::Format::eR8G8B8A8Unorm) { return false; }
+		// all IRenderImage instances are created via IRenderImage::create(), and only ComputeMipMaps images are mutable.
+		auto const& create_info = static_cast<detail::RenderImage const&>(image).get_create_info();
+		return (create_info.flags & ImageFlag::ComputeMipMaps) == ImageFlag::ComputeMipMaps &&
+			   (image.get_usage() & vk::ImageUsageFlagBits::eStorage) == vk::ImageUsageFlagBits::eStorage;
+	}
+
+	auto record(vk::CommandBuffer const command_buffer, IRenderImage& image, MipFilter const filter, vk::ImageLayout const final_layout) -> bool final {
+		if (!is_supported(image)) { return false; }
+
+		auto lock = std::scoped_lock{m_mutex};
+		auto const mip_levels = image.get_mip_levels();
+		auto const layers = image.get_layers();
+		// kaiser taps reach outside a 2x2 quad: shared memory reduction only works for box.
+		auto const per_dispatch = filter == MipFilter::Kaiser ? 1u : mips_per_dispatch_v;
+		auto const dispatches = (mip_levels - 1 + per_dispatch - 1) / per_dispatch * layers;
+		auto& retired = m_retired.emplace_back(Retired{.frame = m_frame_count, .pool = create_pool(dispatches)});
+
+		// all mips stay in General layout while being generated.
+		auto barrier = vk::ImageMemoryBarrier2{};
+		barrier.setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+			.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+			.setDstAccessMask(vk::AccessFlagBits2::eShaderSampledRead | vk::AccessFlagBits2::eShaderStorageWrite)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+			.setOldLayout(image.get_layout())
+			.setNewLayout(vk::ImageLayout::eGeneral);
+		image.transition(command_buffer, barrier);
+
+		command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, *m_pipeline);
+
+		auto const srgb = util::is_srgb(image.get_format());
+		auto const extent = image.get_extent();
+		for (std::uint32_t layer = 0; layer < layers; ++layer) {
+			for (std::uint32_t base = 0; base + 1 < mip_levels; base += per_dispatch) {
+				auto const mip_count = std::min(per_dispatch, mip_levels - 1 - base);
+				auto const base_size = glm::ivec2{int(std::max(extent.width >> base, 1u)), int(std::max(extent.height >> base, 1u))};
+				record_dispatch(command_buffer, image, retired, layer, base, mip_count);
+
+				auto const params = Params{.base_size = base_size, .mip_count = int(mip_count), .filter = int(filter), .srgb = srgb ? 1 : 0};
+				command_buffer.pushConstants(*m_pipeline_layout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(Params), &params);
+				auto const groups = (glm::uvec2{base_size} + group_size_v - 1u) / group_size_v;
+				command_buffer.dispatch(groups.x, groups.y, 1);
+
+				// the next dispatch samples the last mip written by this one.
+				barrier.setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageWrite)
+					.setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
+					.setOldLayout(vk::ImageLayout::eGeneral);
+				image.transition(command_buffer, barrier);
+			}
+		}
+
+		barrier.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+			.setNewLayout(final_layout);
+		image.transition(command_buffer, barrier);
+		return true;
+	}
+
+  private:
+	// descriptors and views must outlive the command buffer they were recorded into, which may be an upload batch
+	// submitted at the start of the next frame.
+	struct Retired {
+		std::uint64_t frame{};
+		vk::UniqueDescriptorPool pool{};
+		std::vector<vk::UniqueImageView> views{};
+	};
+
+	void on_next_frame(FrameIndex /*frame_index*/) final {
+		auto lock = std::scoped_lock{m_mutex};
+		++m_frame_count;
+		while (!m_retired.empty() && m_retired.front().frame + resource_buffering_v + 1 <= m_frame_count) { m_retired.pop_front(); }
+	}
+
+	[[nodiscard]] auto create_pool(std::uint32_t const sets) const -> vk::UniqueDescriptorPool {
+		auto const pool_sizes = std::array{
+			vk::DescriptorPoolSize{vk::DescriptorType::eCombinedImageSampler, sets},
+			vk::DescriptorPoolSize{vk::DescriptorType::eStorageImage, sets * mips_per_dispatch_v},
+		};
+		auto dpci = vk::DescriptorPoolCreateInfo{};
+		dpci.setMaxSets(sets).setPoolSizes(pool_sizes);
+		return m_render_device->get_device().createDescriptorPoolUnique(dpci);
+	}
+
+	void record_dispatch(vk::CommandBuffer const command_buffer, IRenderImage const& image, Retired& retired, std::uint32_t const layer,
+						 std::uint32_t const base, std::uint32_t const mip_count) const {
+		auto const device = m_render_device->get_device();
+		auto const create_view = [&](vk::Format const format, std::uint32_t const mip) {
+			auto const ivci = util::ImageViewCreateInfo{
+				.image = image.get_image(),
+				.format = format,
+				.subresource = vk::ImageSubresourceRange{vk::ImageAspectFlagBits::eColor, mip, 1, layer, 1},
+				// the sRGB base view is only sampled: storage is not supported by its format.
+				.usage = format == util::to_unorm(format) ? vk::ImageUsageFlags{} : vk::ImageUsageFlags{vk::ImageUsageFlagBits::eSampled},
+			};
+			return *retired.views.emplace_back(util::create_image_view(device, ivci));
+		};
+
+		// sampled through the image's own format: sRGB texels are decoded to linear.
+		auto const base_info = vk::DescriptorImageInfo{*m_sampler, create_view(image.get_format(), base), vk::ImageLayout::eGeneral};
+		auto storage_infos = std::array<vk::DescriptorImageInfo, mips_per_dispatch_v>{};
+		for (std::uint32_t i = 0; i < mips_per_dispatch_v; ++i) {
+			// unused slots must still be valid: alias the last written mip.
+			if (i >= mip_count) {
+				storage_infos.at(i) = storage_infos.at(i - 1);
+				continue;
+			}
+			storage_infos.at(i) = vk::DescriptorImageInfo{{}, create_view(util::to_unorm(image.get_format()), base + 1 + i), vk::ImageLayout::eGeneral};
+		}
+
+		auto dsai = vk::DescriptorSetAllocateInfo{};
+		dsai.setDescriptorPool(*retired.pool).setSetLayouts(*m_set_layout);
+		auto set = vk::DescriptorSet{};
+		if (device.allocateDescriptorSets(&dsai, &set) != vk::Result::eSuccess) { throw Panic{"Failed to allocate Vulkan Descriptor Set"}; }
+
+		auto writes = std::array<vk::WriteDescriptorSet, 2>{};
+		writes[0] = util::image_write(&base_info, set, 0);
+		writes[1].setDstSet(set).setDstBinding(1).setDescriptorType(vk::DescriptorType::eStorageImage).setImageInfo(storage_infos);
+		device.updateDescriptorSets(writes, {});
+
+		command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *m_pipeline_layout, 0, set, {});
+	}
+
+	gsl::not_null<IRenderDevice*> m_render_device;
+
+	vk::UniqueDescriptorSetLayout m_set_layout{};
+	vk::UniquePipelineLayout m_pipeline_layout{};
+	vk::UniquePipeline m_pipeline{};
+	vk::UniqueSampler m_sampler{};
+	bool m_storage_supported{};
+
+	std::deque<Retired> m_retired{};
+	std::uint64_t m_frame_count{};
+	std::mutex m_mutex{};
+};
+} // namespace
+
+auto IMipGenerator::create(gsl::not_null<IRenderDevice*> render_device, std::span<std::uint32_t const> const spir_v) -> std::shared_ptr<IMipGenerator> {
+	auto ret = std::make_shared<MipGenerator>(render_device, spir_v);
+	render_device->attach_next_frame_listener(ret);
+	render_device->set_mip_generator(ret);
+	return ret;
+}
+} // namespace kvf
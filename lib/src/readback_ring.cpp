@@ -0,0 +1,204 @@
+#include "kvf/readback_ring.hpp"
+#include "detail/vma.hpp"
+#include "kvf/next_frame_listener.hpp"
+#include "kvf/panic.hpp"
+#include "kvf/render_device.hpp"
+#include "kvf/render_image.hpp"
+#include "kvf/ring.hpp"
+#include "kvf/util.hpp"
+#include "log.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace kvf {
+namespace {
+constexpr vk::DeviceSize alignment_v{16};
+
+[[nodiscard]] constexpr auto is_readable(vk::Format const format) -> bool { return util::is_linear(format) || util::is_srgb(format); }
+[[nodiscard]] constexpr auto is_bgra(vk::Format const format) -> bool { return format == vk::Format::eB8G8R8A8Unorm || format == vk::Format::eB8G8R8A8Srgb; }
+
+// pixels are delivered as RGBA.
+void swap_red_blue(std::span<std::byte> const bytes) {
+	for (std::size_t i = 0; i + 3 < bytes.size(); i += Bitmap::channels_v) { std::swap(bytes[i], bytes[i + 2]); }
+}
+
+class ReadbackRing : public IReadbackRing, public INextFrameListener {
+  public:
+	static constexpr vk::DeviceSize min_block_size_v{8 * 1024 * 1024};
+
+	explicit ReadbackRing(gsl::not_null<IRenderDevice*> render_device) : m_render_device(render_device), m_frame_index(render_device->get_frame_index()) {}
+
+  private:
+	struct Block {
+		detail::vma::UniqueBuffer buffer{};
+		vk::DeviceSize size{};
+		vk::DeviceSize used{};
+	};
+
+	struct Request {
+		std::size_t block{};
+		vk::DeviceSize offset{};
+		glm::ivec2 size{};
+		bool bgra{};
+		ReadbackCallback callback{};
+	};
+
+	struct Frame {
+		std::vector<Block> blocks{};
+		std::vector<Request> requests{};
+		bool submitted{};
+	};
+
+	auto request(vk::CommandBuffer const command_buffer, RenderTarget const& target, vk::ImageLayout const layout, ReadbackCallback callback)
+		-> bool final {
+		if (!command_buffer || !target.image || target.extent.width == 0 || target.extent.height == 0 || layout == vk::ImageLayout::eUndefined) {
+			return false;
+		}
+		if (!is_readable(target.format)) {
+			log.warn("ReadbackRing: Invalid format for readback: {}", vk::to_string(target.format));
+			return false;
+		}
+
+		auto const size = vk::DeviceSize(target.extent.width) * target.extent.height * Bitmap::channels_v;
+		auto& frame = m_frames.at(std::size_t(m_frame_index));
+		auto const [block_index, offset] = allocate(frame, size);
+		auto const buffer = frame.blocks.at(block_index).buffer.get().buffer;
+
+		auto barrier = m_render_device->create_image_barrier();
+		barrier.setImage(target.image)
+			.setOldLayout(layout)
+			.setNewLayout(vk::ImageLayout::eTransferSrcOptimal)
+			.setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+			.setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
+			.setDstAccessMask(vk::AccessFlagBits2::eTransferRead)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eTransfer);
+		barrier.subresourceRange.setLevelCount(1).setLayerCount(1);
+		util::record_barrier(command_buffer, barrier);
+
+		auto bic = vk::BufferImageCopy2{};
+		bic.setBufferOffset(offset)
+			.setImageSubresource(vk::ImageSubresourceLayers{vk::ImageAspectFlagBits::eColor, 0, 0, 1})
+			.setImageExtent(vk::Extent3D{target.extent, 1});
+		auto citbi = vk::CopyImageToBufferInfo2{};
+		citbi.setSrcImage(target.image).setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal).setDstBuffer(buffer).setRegions(bic);
+		command_buffer.copyImageToBuffer2(citbi);
+
+		barrier.setOldLayout(vk::ImageLayout::eTransferSrcOptimal)
+			.setNewLayout(layout)
+			.setSrcAccessMask(vk::AccessFlagBits2::eNone)
+			.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
+			.setDstAccessMask(vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+		auto bmb = vk::BufferMemoryBarrier2{};
+		bmb.setBuffer(buffer)
+			.setOffset(offset)
+			.setSize(size)
+			.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite)
+			.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer)
+			.setDstAccessMask(vk::AccessFlagBits2::eHostRead)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eHost);
+		auto di = vk::DependencyInfo{};
+		di.setImageMemoryBarriers(barrier).setBufferMemoryBarriers(bmb);
+		command_buffer.pipelineBarrier2(di);
+
+		frame.requests.push_back(Request{
+			.block = block_index,
+			.offset = offset,
+			.size = util::to_glm_vec<int>(target.extent),
+			.bgra = is_bgra(target.format),
+			.callback = std::move(callback),
+		});
+		return true;
+	}
+
+	[[nodiscard]] auto get_pending_count() const -> std::size_t final {
+		auto ret = std::size_t{};
+		for (auto const& frame : m_frames) { ret += frame.requests.size(); }
+		return ret;
+	}
+
+	[[nodiscard]] auto get_allocated_size() const -> vk::DeviceSize final {
+		auto ret = vk::DeviceSize{};
+		for (auto const& frame : m_frames) {
+			for (auto const& block : frame.blocks) { ret += block.size; }
+		}
+		return ret;
+	}
+
+	void on_frame_submitted() final { m_frames.at(std::size_t(m_frame_index)).submitted = true; }
+
+	void on_next_frame(FrameIndex const frame_index) final {
+		m_frame_index = frame_index;
+		auto& frame = m_frames.at(std::size_t(m_frame_index));
+
+		// the command buffer is re-recorded from scratch: copies recorded into it never ran.
+		if (!frame.submitted) {
+			for (auto const& request : frame.requests) {
+				if (request.callback) { request.callback(Bitmap{}); }
+			}
+			frame.requests.clear();
+		}
+		frame.submitted = false;
+
+		// this frame's fence has been waited on: copies recorded into it are complete.
+		for (auto const& block : frame.blocks) {
+			if (block.used > 0) { block.buffer.get().invalidate(); }
+		}
+		for (auto const& request : frame.requests) {
+			if (!request.callback) { continue; }
+			auto const& block = frame.blocks.at(request.block);
+			auto const size = std::size_t(request.size.x * request.size.y) * Bitmap::channels_v;
+			auto const bytes = std::span{static_cast<std::byte*>(block.buffer.get().mapped), std::size_t(block.size)}.subspan(request.offset, size);
+			if (request.bgra) { swap_red_blue(bytes); }
+			request.callback(Bitmap{.bytes = bytes, .size = request.size});
+		}
+		frame.requests.clear();
+
+		// release overflow blocks that weren't needed in the last cycle (the first one is retained).
+		if (frame.blocks.size() > 1) {
+			std::erase_if(frame.blocks, [first = &frame.blocks.front()](Block const& block) { return &block != first && block.used == 0; });
+		}
+		for (auto& block : frame.blocks) { block.used = 0; }
+	}
+
+	auto allocate(Frame& frame, vk::DeviceSize const size) -> std::pair<std::size_t, vk::DeviceSize> {
+		for (std::size_t index = 0; index < frame.blocks.size(); ++index) {
+			auto& block = frame.blocks[index];
+			auto const offset = (block.used + alignment_v - 1) / alignment_v * alignment_v;
+			if (offset + size > block.size) { continue; }
+			block.used = offset + size;
+			return {index, offset};
+		}
+
+		auto const bci = BufferCreateInfo{
+			.usage = vk::BufferUsageFlagBits::eTransferDst,
+			.type = BufferType::Readback,
+			.size = std::max(size, min_block_size_v),
+		};
+		auto& block = frame.blocks.emplace_back(detail::get_vma(*m_render_device).create_buffer(bci), bci.size, size);
+		if (block.buffer.get().mapped == nullptr) { throw Panic{"Failed to map readback buffer"}; }
+		return {frame.blocks.size() - 1, 0};
+	}
+
+	gsl::not_null<IRenderDevice*> m_render_device;
+	Ring<Frame> m_frames{};
+	FrameIndex m_frame_index{};
+};
+
+} // namespace
+
+auto IReadbackRing::create(gsl::not_null<IRenderDevice*> render_device) -> std::shared_ptr<IReadbackRing> {
+	auto ret = std::make_shared<ReadbackRing>(render_device);
+	render_device->attach_next_frame_listener(ret);
+	return ret;
+}
+
+auto IReadbackRing::request(vk::CommandBuffer const command_buffer, IRenderImage const& image, ReadbackCallback callback) -> bool {
+	if (image.get_aspect() != vk::ImageAspectFlagBits::eColor ||
+		image.get_samples() != vk::SampleCountFlagBits::e1 || image.get_layout() == vk::ImageLayout::eUndefined) {
+		log.warn("ReadbackRing: Invalid aspect/samples/layout for readback");
+		return false;
+	}
+	return request(command_buffer, image.render_target(), image.get_layout(), std::move(callback));
+}
+} // namespace kvf
@@ -1,6 +1,14 @@
 #include "kvf/render_device.hpp"
+#include "detail/bindless_table.hpp"
+#include "detail/deferred_writer.hpp"
+#include "detail/defragmenter.hpp"
+#include "detail/render_target_pool.hpp"
+#include "detail/ring_descriptor_buffer.hpp"
+#include "detail/upload_queue.hpp"
+#include "detail/vma.hpp"
 #include "kvf/build_version.hpp"
 #include "kvf/device_waiter.hpp"
+#include "kvf/mip_generator.hpp"
 #include "kvf/panic.hpp"
 #include "kvf/ring.hpp"
 #include "kvf/util.hpp"
@@ -110,39 +118,14 @@ constexpr auto layout_masks_for(vk::ImageLayout const layout, std::span<LayoutMa
 	return *it;
 }
 
-class VulkanAllocator {
-  public:
-	VulkanAllocator(VulkanAllocator const&) = delete;
-	VulkanAllocator(VulkanAllocator&&) = delete;
-	VulkanAllocator& operator=(VulkanAllocator const&) = delete;
-	VulkanAllocator& operator=(VulkanAllocator&&) = delete;
-
-	explicit VulkanAllocator(vk::Instance const instance, Gpu const& gpu, vk::Device const device) {
-		auto allocator_ci = VmaAllocatorCreateInfo{};
-		allocator_ci.instance = instance;
-		allocator_ci.physicalDevice = gpu.device;
-		allocator_ci.device = device;
-		auto dl = VULKAN_HPP_DEFAULT_DISPATCHER;
-		auto vkFunc = VmaVulkanFunctions{};
-		vkFunc.vkGetInstanceProcAddr = dl.vkGetInstanceProcAddr;
-		vkFunc.vkGetDeviceProcAddr = dl.vkGetDeviceProcAddr;
-		allocator_ci.pVulkanFunctions = &vkFunc;
-		if (vmaCreateAllocator(&allocator_ci, &m_allocator) != VK_SUCCESS) { throw Panic{"Failed to create Vulkan Allocator"}; }
-	}
-
-	~VulkanAllocator() { vmaDestroyAllocator(m_allocator); }
-
-	[[nodiscard]] auto get() const -> VmaAllocator { return m_allocator; }
-
-	operator VmaAllocator() const { return get(); }
-
-  private:
-	VmaAllocator m_allocator{};
+struct QueueFamilies {
+	std::uint32_t graphics{};
+	std::optional<std::uint32_t> transfer{};
 };
 
 struct GpuList {
 	std::vector<Gpu> gpus{};
-	std::vector<std::uint32_t> queue_families{};
+	std::vector<QueueFamilies> queue_families{};
 
 	static constexpr auto has_required_extensions(std::span<vk::ExtensionProperties const> available) {
 		auto const has_extension = [available](char const* name) {
@@ -164,6 +147,16 @@ struct GpuList {
 			}
 			return false;
 		};
+		// prefer transfer-only families (DMA engines) over async compute ones.
+		auto const get_transfer_family = [](vk::PhysicalDevice device) -> std::optional<std::uint32_t> {
+			auto ret = std::optional<std::uint32_t>{};
+			for (auto const& [index, family] : std::ranges::enumerate_view(device.getQueueFamilyProperties())) {
+				if (!(family.queueFlags & vk::QueueFlagBits::eTransfer) || (family.queueFlags & vk::QueueFlagBits::eGraphics)) { continue; }
+				if (!(family.queueFlags & vk::QueueFlagBits::eCompute)) { return static_cast<std::uint32_t>(index); }
+				if (!ret) { ret = static_cast<std::uint32_t>(index); }
+			}
+			return ret;
+		};
 		for (auto const& device : all_devices) {
 			if (device.getProperties().apiVersion < VK_API_VERSION_1_3) { continue; }
 			if (!has_required_extensions(device.enumerateDeviceExtensionProperties())) { continue; }
@@ -171,13 +164,13 @@ struct GpuList {
 			if (!get_queue_family(device, queue_family)) { continue; }
 			if (device.getSurfaceSupportKHR(queue_family, surface) == vk::False) { continue; }
 			ret.gpus.push_back(Gpu{.device = device, .properties = device.getProperties(), .features = device.getFeatures()});
-			ret.queue_families.push_back(queue_family);
+			ret.queue_families.push_back(QueueFamilies{.graphics = queue_family, .transfer = get_transfer_family(device)});
 		}
 		return ret;
 	}
 
-	[[nodiscard]] auto get_queue_family(gsl::not_null<Gpu const*> gpu) const -> std::uint32_t {
-		for (auto [g, q] : std::ranges::zip_view(gpus, queue_families)) {
+	[[nodiscard]] auto get_queue_families(gsl::not_null<Gpu const*> gpu) const -> QueueFamilies const& {
+		for (auto const& [g, q] : std::ranges::zip_view(gpus, queue_families)) {
 			if (&g == gpu) { return q; }
 		}
 		throw Panic{"Invalid GPU"};
@@ -487,7 +480,10 @@ class RenderDevice : public IRenderDevice {
 		select_gpu(create_info.gpu_selector);
 		create_device();
 		create_swapchain();
-		m_allocator.emplace(*m_instance, m_gpu, *m_device);
+		m_allocator.emplace(*m_instance, m_gpu.device, *m_device, m_memory_budget);
+		m_allocator->create_pool(MemoryCategory::Staging, create_info.staging_pool);
+		m_allocator->create_pool(MemoryCategory::Upload, create_info.upload_pool);
+		m_allocator->create_pool(MemoryCategory::RingBuffer, create_info.frame_pool);
 
 		create_dear_imgui();
 
@@ -495,6 +491,19 @@ class RenderDevice : public IRenderDevice {
 		create_command_buffers();
 
 		create_descriptor_allocator(create_info.custom_pool_sizes, create_info.sets_per_pool);
+		if ((m_flags & RenderDeviceFlag::DescriptorBufferFeature) == RenderDeviceFlag::DescriptorBufferFeature) {
+			m_descriptor_buffer = std::make_shared<detail::RingDescriptorBuffer>(this, create_info.descriptor_buffer_size);
+			attach_next_frame_listener(m_descriptor_buffer);
+		}
+		m_upload_queue.emplace(this);
+		m_deferred_writer.emplace(this);
+		m_defragmenter.emplace(this, create_info.defrag);
+		m_render_target_pool = std::make_shared<detail::RenderTargetPool>(this);
+		attach_next_frame_listener(m_render_target_pool);
+		if (m_descriptor_indexing) {
+			m_bindless_table = std::make_shared<detail::BindlessTable>(this, create_info.bindless);
+			attach_next_frame_listener(m_bindless_table);
+		}
 
 		m_dear_imgui->new_frame();
 	}
@@ -515,7 +524,15 @@ class RenderDevice : public IRenderDevice {
 	[[nodiscard]] auto get_surface() const -> vk::SurfaceKHR final { return *m_surface; }
 	[[nodiscard]] auto get_device() const -> vk::Device final { return *m_device; }
 	[[nodiscard]] auto get_queue_family() const -> std::uint32_t final { return m_queue_family; }
-	[[nodiscard]] auto get_allocator() const -> VmaAllocator final { return *m_allocator; }
+	[[nodiscard]] auto get_transfer_queue_family() const -> std::uint32_t final { return m_transfer_queue_family; }
+	[[nodiscard]] auto get_allocator() const -> VmaAllocator final { return m_allocator->get(); }
+	[[nodiscard]] auto get_vma() -> detail::vma::Allocator& { return *m_allocator; }
+	[[nodiscard]] auto get_memory_stats() const -> MemoryStats final {
+		auto ret = m_allocator->get_memory_stats();
+		ret.memory_budget_ext = m_memory_budget;
+		return ret;
+	}
+	void request_defragmentation() final { m_defragmenter->request(); }
 
 	[[nodiscard]] auto get_swapchain_image_extent() const -> vk::Extent2D final { return m_swapchain.get_info().imageExtent; }
 	[[nodiscard]] auto get_swapchain_color_format() const -> vk::Format final { return m_swapchain.get_info().imageFormat; }
@@ -540,12 +557,37 @@ class RenderDevice : public IRenderDevice {
 	void attach_next_frame_listener(std::weak_ptr<INextFrameListener> listener) final { m_next_frame_listeners.push_back(std::move(listener)); }
 
 	[[nodiscard]] auto get_descriptor_allocator() -> IRingDescriptorAllocator& final { return *m_descriptor_allocator; }
+	[[nodiscard]] auto get_descriptor_buffer() -> klib::Ptr<IRingDescriptorBuffer> final { return m_descriptor_buffer.get(); }
+	[[nodiscard]] auto has_push_descriptors() const -> bool final { return m_push_descriptors; }
+	[[nodiscard]] auto get_upload_queue() -> IUploadQueue& final { return *m_upload_queue; }
+	[[nodiscard]] auto get_render_target_pool() -> IRenderTargetPool& final { return *m_render_target_pool; }
+	[[nodiscard]] auto get_bindless_table() const -> klib::Ptr<IBindlessTable> final { return m_bindless_table.get(); }
+	[[nodiscard]] auto get_mip_generator() const -> klib::Ptr<IMipGenerator> final { return m_mip_generator.get(); }
+	void set_mip_generator(std::shared_ptr<IMipGenerator> mip_generator) final { m_mip_generator = std::move(mip_generator); }
+
+	void defer_write(vk::Buffer const dst, std::span<BufferWrite const> writes, vk::DeviceSize const offset) final {
+		m_deferred_writer->enqueue(dst, writes, offset);
+	}
+
+	void flush_deferred_writes() final {
+		if (!m_current_cmd) { return; }
+		m_deferred_writer->flush(m_current_cmd, FrameIndex{m_frame_index});
+	}
 
 	void queue_submit(vk::SubmitInfo2 const& si, vk::Fence const fence) final {
 		auto const lock = std::scoped_lock{m_mutex};
 		m_queue.submit2(si, fence);
 	}
 
+	void transfer_queue_submit(vk::SubmitInfo2 const& si, vk::Fence const fence) final {
+		if (!has_dedicated_transfer_queue()) {
+			queue_submit(si, fence);
+			return;
+		}
+		auto const lock = std::scoped_lock{m_transfer_mutex};
+		m_transfer_queue.submit2(si, fence);
+	}
+
 	auto next_frame() -> vk::CommandBuffer final {
 		begin_frame();
 		return m_current_cmd;
@@ -604,16 +646,21 @@ class RenderDevice : public IRenderDevice {
 		auto list = GpuList::get_viable(*m_instance, *m_surface);
 		if (list.gpus.empty()) { throw Panic{"No viable GPUs"}; }
 		auto const gpu = selector.select(list.gpus);
-		m_queue_family = list.get_queue_family(gpu);
+		auto const& queue_families = list.get_queue_families(gpu);
+		m_queue_family = queue_families.graphics;
+		m_transfer_queue_family = queue_families.transfer.value_or(m_queue_family);
 		m_gpu = *gpu;
 		m_optimal_depth_format = optimal_depth_format(m_gpu.device);
-		log.debug("Using GPU: {}, queue family: {}", m_gpu.properties.deviceName.data(), m_queue_family);
+		log.debug("Using GPU: {}, queue family: {}, transfer queue family: {}", m_gpu.properties.deviceName.data(), m_queue_family, m_transfer_queue_family);
 	}
 
 	void create_device() {
-		auto qci = vk::DeviceQueueCreateInfo{};
 		static constexpr auto queue_priorities_v = std::array{1.0f};
-		qci.setQueueFamilyIndex(m_queue_family).setQueueCount(1).setQueuePriorities(queue_priorities_v);
+		auto qcis = std::vector<vk::DeviceQueueCreateInfo>{};
+		qcis.emplace_back().setQueueFamilyIndex(m_queue_family).setQueueCount(1).setQueuePriorities(queue_priorities_v);
+		if (has_dedicated_transfer_queue()) {
+			qcis.emplace_back().setQueueFamilyIndex(m_transfer_queue_family).setQueueCount(1).setQueuePriorities(queue_priorities_v);
+		}
 
 		auto enabled_features = vk::PhysicalDeviceFeatures{};
 		enabled_features.fillModeNonSolid = m_gpu.features.fillModeNonSolid;
@@ -623,21 +670,66 @@ class RenderDevice : public IRenderDevice {
 
 		auto dr_feature = vk::PhysicalDeviceDynamicRenderingFeatures{vk::True};
 		auto sync_feature = vk::PhysicalDeviceSynchronization2Features{vk::True, &dr_feature};
+		auto bda_feature = vk::PhysicalDeviceBufferDeviceAddressFeatures{vk::True};
+		bda_feature.setPNext(&sync_feature);
+		auto timeline_feature = vk::PhysicalDeviceTimelineSemaphoreFeatures{vk::True, &bda_feature};
 		auto shader_obj_feature = vk::PhysicalDeviceShaderObjectFeaturesEXT{vk::True};
 
+		// optional: only the features used by the bindless table.
+		auto const indexing_support = m_gpu.device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorIndexingFeatures>()
+										  .get<vk::PhysicalDeviceDescriptorIndexingFeatures>();
+		m_descriptor_indexing = indexing_support.shaderSampledImageArrayNonUniformIndexing && indexing_support.descriptorBindingSampledImageUpdateAfterBind &&
+								indexing_support.descriptorBindingUpdateUnusedWhilePending && indexing_support.descriptorBindingPartiallyBound &&
+								indexing_support.runtimeDescriptorArray;
+		auto indexing_feature = vk::PhysicalDeviceDescriptorIndexingFeatures{};
+		indexing_feature.setShaderSampledImageArrayNonUniformIndexing(vk::True)
+			.setDescriptorBindingSampledImageUpdateAfterBind(vk::True)
+			.setDescriptorBindingUpdateUnusedWhilePending(vk::True)
+			.setDescriptorBindingPartiallyBound(vk::True)
+			.setRuntimeDescriptorArray(vk::True)
+			.setPNext(&timeline_feature);
+
 		auto dci = vk::DeviceCreateInfo{};
 		auto extensions = std::vector{VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+		auto const available_extensions = m_gpu.device.enumerateDeviceExtensionProperties();
+		auto const has_extension = [&available_extensions](std::string_view const name) {
+			return std::ranges::any_of(available_extensions, [name](vk::ExtensionProperties const& props) { return props.extensionName.data() == name; });
+		};
+		m_memory_budget = has_extension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		if (m_memory_budget) { extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME); }
+		m_push_descriptors = has_extension(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+		if (m_push_descriptors) { extensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME); }
 		if ((m_flags & RenderDeviceFlag::ShaderObjectFeature) == RenderDeviceFlag::ShaderObjectFeature) {
 			dr_feature.setPNext(&shader_obj_feature);
 			extensions.push_back("VK_EXT_shader_object");
 		}
-		dci.setPEnabledExtensionNames(extensions).setQueueCreateInfos(qci).setPEnabledFeatures(&enabled_features).setPNext(&sync_feature);
+		auto descriptor_buffer_feature = vk::PhysicalDeviceDescriptorBufferFeaturesEXT{vk::True};
+		if ((m_flags & RenderDeviceFlag::DescriptorBufferFeature) == RenderDeviceFlag::DescriptorBufferFeature) {
+			auto const support = m_gpu.device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorBufferFeaturesEXT>()
+									 .get<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>();
+			if (has_extension(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME) && support.descriptorBuffer) {
+				descriptor_buffer_feature.setPNext(dr_feature.pNext);
+				dr_feature.setPNext(&descriptor_buffer_feature);
+				extensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+			} else {
+				log.warn("VK_EXT_descriptor_buffer not supported");
+				m_flags &= ~RenderDeviceFlag::DescriptorBufferFeature;
+			}
+		}
+		dci.setPEnabledExtensionNames(extensions).setQueueCreateInfos(qcis).setPEnabledFeatures(&enabled_features);
+		if (m_descriptor_indexing) {
+			dci.setPNext(&indexing_feature);
+		} else {
+			dci.setPNext(&timeline_feature);
+			log.debug("Descriptor indexing not supported, bindless table disabled");
+		}
 
 		m_device = m_gpu.device.createDeviceUnique(dci);
 		if (!m_device) { throw Panic{"Failed to create Vulkan Device"}; }
 		VULKAN_HPP_DEFAULT_DISPATCHER.init(*m_device);
 
 		m_queue = m_device->getQueue(m_queue_family, 0);
+		m_transfer_queue = has_dedicated_transfer_queue() ? m_device->getQueue(m_transfer_queue_family, 0) : m_queue;
 		log.debug("Vulkan Device created");
 
 		m_device_waiter.get() = *m_device;
@@ -724,8 +816,18 @@ class RenderDevice : public IRenderDevice {
 			return true;
 		});
 
+		// submit uploads enqueued during the previous frame ahead of this one.
+		m_upload_queue->release_retired(FrameIndex{m_frame_index});
+		m_upload_queue->flush();
+		// moves are submitted (and pending writes retargeted) before anything is recorded for this frame.
+		m_defragmenter->update(*m_deferred_writer);
+		m_upload_queue->set_transfer_wait(m_defragmenter->get_timeline(), m_defragmenter->get_value());
+		if (m_bindless_table) { m_bindless_table->refresh(); }
+
 		m_current_cmd = m_command_buffers.at(m_frame_index);
 		m_current_cmd.begin(vk::CommandBufferBeginInfo{vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+		if (m_descriptor_buffer) { m_descriptor_buffer->bind_buffers(m_current_cmd); }
+		m_deferred_writer->record(m_current_cmd, FrameIndex{m_frame_index});
 	}
 
 	auto acquire_next_image() -> bool {
@@ -755,12 +857,19 @@ class RenderDevice : public IRenderDevice {
 		return true;
 	}
 
+	void notify_frame_submitted() {
+		for (auto const& ptr : m_next_frame_listeners) {
+			if (auto listener = ptr.lock()) { listener->on_frame_submitted(); }
+		}
+	}
+
 	void perform_render(RenderTarget const& frame, vk::Filter const filter) {
 		m_backbuffer_layout = vk::ImageLayout::eUndefined;
 		auto const backbuffer = RenderTarget{
 			.image = m_swapchain.get_image(),
 			.view = m_swapchain.get_image_view(),
 			.extent = m_swapchain.get_info().imageExtent,
+			.format = m_swapchain.get_info().imageFormat,
 		};
 		KLIB_ASSERT(backbuffer.image && backbuffer.view);
 
@@ -799,11 +908,17 @@ class RenderDevice : public IRenderDevice {
 		auto si = vk::SubmitInfo2{};
 		si.setCommandBufferInfos(cbsi).setWaitSemaphoreInfos(wssi).setSignalSemaphoreInfos(sssi);
 
+		// views replaced while recording are read at submission (update after bind).
+		if (m_bindless_table) { m_bindless_table->refresh(); }
+
 		auto lock = std::unique_lock{m_mutex};
 		m_queue.submit2(si, *sync.drawn);
+		m_deferred_writer->on_submitted();
 		auto const present_sucess = m_swapchain.present(m_queue);
 		lock.unlock();
 
+		notify_frame_submitted();
+
 		if (!present_sucess) { m_swapchain.recreate(get_framebuffer_extent()); }
 
 		m_frame_index = (m_frame_index + 1) % resource_buffering_v;
@@ -878,11 +993,15 @@ class RenderDevice : public IRenderDevice {
 
 	gsl::not_null<GLFWwindow*> m_window;
 	RenderDeviceFlag m_flags{};
+	bool m_memory_budget{};
+	bool m_descriptor_indexing{};
+	bool m_push_descriptors{};
 
 	klib::Version m_loader_version{};
 	vk::UniqueInstance m_instance{};
 	Gpu m_gpu{};
 	std::uint32_t m_queue_family{};
+	std::uint32_t m_transfer_queue_family{};
 	vk::Format m_optimal_depth_format{};
 	vk::UniqueSurfaceKHR m_surface{};
 
@@ -891,8 +1010,9 @@ class RenderDevice : public IRenderDevice {
 	std::vector<vk::PresentModeKHR> m_present_modes{};
 	Swapchain m_swapchain{};
 	vk::Queue m_queue{};
+	vk::Queue m_transfer_queue{};
 
-	std::optional<VulkanAllocator> m_allocator{};
+	std::optional<detail::vma::Allocator> m_allocator{};
 
 	std::optional<DearImGui> m_dear_imgui{};
 
@@ -901,6 +1021,13 @@ class RenderDevice : public IRenderDevice {
 	Ring<vk::CommandBuffer> m_command_buffers{};
 
 	std::shared_ptr<RingDescriptorAllocator> m_descriptor_allocator{};
+	std::shared_ptr<detail::RingDescriptorBuffer> m_descriptor_buffer{};
+	std::optional<detail::UploadQueue> m_upload_queue{};
+	std::optional<detail::DeferredWriter> m_deferred_writer{};
+	std::optional<detail::Defragmenter> m_defragmenter{};
+	std::shared_ptr<detail::RenderTargetPool> m_render_target_pool{};
+	std::shared_ptr<detail::BindlessTable> m_bindless_table{};
+	std::shared_ptr<IMipGenerator> m_mip_generator{};
 
 	std::vector<std::weak_ptr<INextFrameListener>> m_next_frame_listeners{};
 	std::size_t m_frame_index{};
@@ -910,10 +1037,14 @@ class RenderDevice : public IRenderDevice {
 	bool m_render_imgui{true};
 
 	std::mutex m_mutex{};
+	std::mutex m_transfer_mutex{};
 	DeviceWaiter m_device_waiter{};
 };
 } // namespace
 
+// every IRenderDevice that creates kvf resources is a RenderDevice.
+auto detail::get_vma(IRenderDevice& render_device) -> vma::Allocator& { return static_cast<RenderDevice&>(render_device).get_vma(); }
+
 auto IRenderDevice::create(gsl::not_null<GLFWwindow*> window, CreateInfo const& create_info) -> std::unique_ptr<IRenderDevice> {
 	return std::make_unique<RenderDevice>(window, create_info);
 }
@@ -924,6 +1055,25 @@ auto IRenderDevice::create_sampler(vk::SamplerCreateInfo create_info) const -> v
 	return get_device().createSamplerUnique(create_info);
 }
 
+auto IRenderDevice::create_push_set_layout(std::span<vk::DescriptorSetLayoutBinding const> bindings) const -> PushSetLayout {
+	auto ret = PushSetLayout{};
+	if (has_push_descriptors()) {
+		auto const max_push_descriptors = get_gpu()
+											  .device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDevicePushDescriptorPropertiesKHR>()
+											  .get<vk::PhysicalDevicePushDescriptorPropertiesKHR>()
+											  .maxPushDescriptors;
+		auto descriptor_count = std::uint64_t{};
+		for (auto const& binding : bindings) { descriptor_count += binding.descriptorCount; }
+		ret.push = descriptor_count <= max_push_descriptors;
+		if (!ret.push) { log.debug("Push set layout with {} descriptors exceeds maxPushDescriptors ({})", descriptor_count, max_push_descriptors); }
+	}
+	auto dslci = vk::DescriptorSetLayoutCreateInfo{};
+	dslci.setBindings(bindings);
+	if (ret.push) { dslci.setFlags(vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR); }
+	ret.layout = get_device().createDescriptorSetLayoutUnique(dslci);
+	return ret;
+}
+
 auto IRenderDevice::create_shader_objects(ShaderObjectCreateInfo const& create_info) const -> std::array<vk::UniqueShaderEXT, 2> {
 	if ((get_flags() & RenderDeviceFlag::ShaderObjectFeature) != RenderDeviceFlag::ShaderObjectFeature) {
 		log.warn("Attempt to create ShaderEXT objects without ShaderObjectFeature");
@@ -1019,6 +1169,9 @@ auto IRenderDevice::create_pipeline(vk::PipelineLayout layout, PipelineState con
 		.setPMultisampleState(&multisample_state_ci)
 		.setLayout(layout)
 		.setPNext(&rendering_ci);
+	if ((state.flags & PipelineFlag::DescriptorBuffer) == PipelineFlag::DescriptorBuffer) {
+		graphics_pipeline_ci.setFlags(vk::PipelineCreateFlagBits::eDescriptorBufferEXT);
+	}
 
 	auto const device = get_device();
 	auto ret = vk::Pipeline{};
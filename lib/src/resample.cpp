@@ -0,0 +1,229 @@
+#include "kvf/resample.hpp"
+#include "kvf/is_positive.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KVF_RESAMPLE_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define KVF_RESAMPLE_NEON
+#endif
+
+namespace kvf {
+namespace {
+// RGBA as 4 contiguous floats: one SIMD lane per channel.
+constexpr auto channels_v = std::size_t(Bitmap::channels_v);
+
+// 12 bits of precision is enough to round-trip 8 bit sRGB.
+constexpr std::size_t encode_lut_size_v{4096};
+
+struct SrgbLut {
+	std::array<float, 256> decode{};
+	std::array<std::uint8_t, encode_lut_size_v> encode{};
+
+	SrgbLut() {
+		for (std::size_t i = 0; i < decode.size(); ++i) { decode[i] = Color::srgb_to_linear(glm::vec4{Color::to_f32(std::uint8_t(i))}).x; }
+		for (std::size_t i = 0; i < encode.size(); ++i) {
+			auto const linear = float(i) / float(encode.size() - 1);
+			encode[i] = std::uint8_t(std::lround(Color::linear_to_srgb(glm::vec4{linear}).x * float(Color::channel_max_v)));
+		}
+	}
+};
+
+auto srgb_lut() -> SrgbLut const& {
+	static auto const ret = SrgbLut{};
+	return ret;
+}
+
+[[nodiscard]] auto sinc(float const x) -> float {
+	if (std::abs(x) < 1e-6f) { return 1.0f; }
+	auto const px = std::numbers::pi_v<float> * x;
+	return std::sin(px) / px;
+}
+
+[[nodiscard]] constexpr auto support_of(ResampleFilter const filter) -> float {
+	switch (filter) {
+	case ResampleFilter::Box: return 0.5f;
+	case ResampleFilter::Triangle: return 1.0f;
+	default:
+	case ResampleFilter::Lanczos3: return 3.0f;
+	}
+}
+
+[[nodiscard]] auto evaluate(ResampleFilter const filter, float const x) -> float {
+	switch (filter) {
+	case ResampleFilter::Box: return (x >= -0.5f && x < 0.5f) ? 1.0f : 0.0f;
+	case ResampleFilter::Triangle: return std::max(1.0f - std::abs(x), 0.0f);
+	default:
+	case ResampleFilter::Lanczos3: return std::abs(x) < 3.0f ? sinc(x) * sinc(x / 3.0f) : 0.0f;
+	}
+}
+
+// Weights of source pixels contributing to each destination pixel along one axis.
+struct Contributors {
+	struct Span {
+		std::size_t first_weight{};
+		int first_source{};
+		int count{};
+	};
+
+	std::vector<Span> spans{};
+	std::vector<float> weights{};
+
+	explicit Contributors(ResampleFilter const filter, int const src_size, int const dst_size) {
+		auto const ratio = float(src_size) / float(dst_size);
+		// when minifying, stretch the kernel to cover the full footprint of each destination pixel.
+		auto const scale = std::max(ratio, 1.0f);
+		auto const support = support_of(filter) * scale;
+
+		spans.reserve(std::size_t(dst_size));
+		auto window = std::vector<float>{};
+		for (int dst = 0; dst < dst_size; ++dst) {
+			auto const center = (float(dst) + 0.5f) * ratio;
+			auto const left = int(std::floor(center - support));
+			auto const right = int(std::ceil(center + support));
+
+			// clamp-to-edge: fold out-of-bounds taps onto the border pixels.
+			auto const first = std::clamp(left, 0, src_size - 1);
+			auto const last = std::clamp(right, 0, src_size - 1);
+			window.assign(std::size_t(last - first + 1), 0.0f);
+			auto total = 0.0f;
+			for (int src = left; src <= right; ++src) {
+				auto const weight = evaluate(filter, (float(src) + 0.5f - center) / scale);
+				if (weight == 0.0f) { continue; }
+				window[std::size_t(std::clamp(src, 0, src_size - 1) - first)] += weight;
+				total += weight;
+			}
+			if (total == 0.0f) {
+				// kernel missed every tap (tiny box on a magnification): nearest neighbour.
+				spans.push_back(Span{.first_weight = weights.size(), .first_source = std::clamp(int(center), 0, src_size - 1), .count = 1});
+				weights.push_back(1.0f);
+				continue;
+			}
+
+			spans.push_back(Span{.first_weight = weights.size(), .first_source = first, .count = int(window.size())});
+			for (auto const weight : window) { weights.push_back(weight / total); }
+		}
+	}
+};
+
+// dst[i] += weight * src[i] for i in [0, count).
+void multiply_add(float* dst, float const* src, float const weight, std::size_t const count) {
+	auto i = std::size_t{};
+#if defined(KVF_RESAMPLE_SSE2)
+	auto const w = _mm_set1_ps(weight);
+	for (; i + 4 <= count; i += 4) { _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), w))); }
+#elif defined(KVF_RESAMPLE_NEON)
+	for (; i + 4 <= count; i += 4) { vst1q_f32(dst + i, vmlaq_n_f32(vld1q_f32(dst + i), vld1q_f32(src + i), weight)); }
+#endif
+	for (; i < count; ++i) { dst[i] += weight * src[i]; }
+}
+
+[[nodiscard]] auto decode(Bitmap const& bitmap, ResampleInfo const& info) -> std::vector<float> {
+	auto const& lut = srgb_lut();
+	auto ret = std::vector<float>(bitmap.bytes.size());
+	for (std::size_t i = 0; i < bitmap.bytes.size(); i += channels_v) {
+		auto const alpha = Color::to_f32(std::uint8_t(bitmap.bytes[i + 3]));
+		auto const factor = info.premultiply_alpha ? alpha : 1.0f;
+		for (std::size_t c = 0; c < 3; ++c) {
+			auto const byte = std::uint8_t(bitmap.bytes[i + c]);
+			ret[i + c] = factor * (info.srgb ? lut.decode[byte] : Color::to_f32(byte));
+		}
+		ret[i + 3] = alpha;
+	}
+	return ret;
+}
+
+[[nodiscard]] auto encode(std::vector<float> const& pixels, glm::ivec2 const size, ResampleInfo const& info) -> ColorBitmap {
+	auto const& lut = srgb_lut();
+	auto const to_u8 = [](float const norm) { return std::uint8_t(std::lround(std::clamp(norm, 0.0f, 1.0f) * float(Color::channel_max_v))); };
+	auto const encode_channel = [&](float const linear) {
+		if (!info.srgb) { return to_u8(linear); }
+		auto const index = std::lround(std::clamp(linear, 0.0f, 1.0f) * float(lut.encode.size() - 1));
+		return lut.encode[std::size_t(index)];
+	};
+
+	auto ret = std::vector<Color>{};
+	ret.reserve(pixels.size() / channels_v);
+	for (std::size_t i = 0; i < pixels.size(); i += channels_v) {
+		auto const alpha = std::clamp(pixels[i + 3], 0.0f, 1.0f);
+		// fully transparent pixels have no recoverable color when premultiplied.
+		auto const factor = info.premultiply_alpha ? (alpha > 0.0f ? 1.0f / alpha : 0.0f) : 1.0f;
+		auto color = Color{};
+		color.x = encode_channel(pixels[i + 0] * factor);
+		color.y = encode_channel(pixels[i + 1] * factor);
+		color.z = encode_channel(pixels[i + 2] * factor);
+		color.w = to_u8(alpha);
+		ret.push_back(color);
+	}
+	return ColorBitmap{std::move(ret), size};
+}
+
+[[nodiscard]] auto resample_linear(std::vector<float> const& src, glm::ivec2 const src_size, glm::ivec2 const dst_size, ResampleFilter const filter)
+	-> std::vector<float> {
+	auto const horz = Contributors{filter, src_size.x, dst_size.x};
+	auto const vert = Contributors{filter, src_size.y, dst_size.y};
+
+	// horizontal pass: src_size.y rows of dst_size.x pixels.
+	auto const src_stride = std::size_t(src_size.x) * channels_v;
+	auto const dst_stride = std::size_t(dst_size.x) * channels_v;
+	auto temp = std::vector<float>(dst_stride * std::size_t(src_size.y));
+	for (int y = 0; y < src_size.y; ++y) {
+		auto const* src_row = src.data() + (std::size_t(y) * src_stride);
+		auto* dst_row = temp.data() + (std::size_t(y) * dst_stride);
+		for (std::size_t x = 0; x < horz.spans.size(); ++x) {
+			auto const& span = horz.spans[x];
+			auto* dst_pixel = dst_row + (x * channels_v);
+			for (int i = 0; i < span.count; ++i) {
+				auto const* src_pixel = src_row + (std::size_t(span.first_source + i) * channels_v);
+				multiply_add(dst_pixel, src_pixel, horz.weights[span.first_weight + std::size_t(i)], channels_v);
+			}
+		}
+	}
+
+	// vertical pass: accumulate whole weighted rows.
+	auto ret = std::vector<float>(dst_stride * std::size_t(dst_size.y));
+	for (std::size_t y = 0; y < vert.spans.size(); ++y) {
+		auto const& span = vert.spans[y];
+		auto* dst_row = ret.data() + (y * dst_stride);
+		for (int i = 0; i < span.count; ++i) {
+			auto const* src_row = temp.data() + (std::size_t(span.first_source + i) * dst_stride);
+			multiply_add(dst_row, src_row, vert.weights[span.first_weight + std::size_t(i)], dst_stride);
+		}
+	}
+
+	return ret;
+}
+
+[[nodiscard]] auto is_valid(Bitmap const& bitmap) -> bool {
+	if (!is_positive(bitmap.size)) { return false; }
+	return bitmap.bytes.size() == std::size_t(bitmap.size.x * bitmap.size.y) * channels_v;
+}
+} // namespace
+
+auto resample(Bitmap const& bitmap, glm::ivec2 const size, ResampleInfo const& info) -> ColorBitmap {
+	if (!is_valid(bitmap) || !is_positive(size)) { return {}; }
+	auto const src = decode(bitmap, info);
+	return encode(resample_linear(src, bitmap.size, size, info.filter), size, info);
+}
+
+auto create_mip_chain(Bitmap const& bitmap, ResampleInfo const& info) -> std::vector<ColorBitmap> {
+	if (!is_valid(bitmap)) { return {}; }
+
+	auto ret = std::vector<ColorBitmap>{};
+	// stay in linear float between levels: no quantization / gamma round trip per level.
+	auto level = decode(bitmap, info);
+	auto size = bitmap.size;
+	while (size.x > 1 || size.y > 1) {
+		auto const next_size = glm::ivec2{std::max(size.x / 2, 1), std::max(size.y / 2, 1)};
+		level = resample_linear(level, size, next_size, info.filter);
+		size = next_size;
+		ret.push_back(encode(level, size, info));
+	}
+	return ret;
+}
+} // namespace kvf
@@ -0,0 +1,181 @@
+#include "kvf/texture_atlas.hpp"
+#include "kvf/is_positive.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace kvf {
+namespace {
+[[nodiscard]] constexpr auto is_valid(Bitmap const& bitmap) -> bool {
+	if (!is_positive(bitmap.size)) { return false; }
+	return bitmap.bytes.size() == std::size_t(bitmap.size.x * bitmap.size.y) * Bitmap::channels_v;
+}
+} // namespace
+
+TextureAtlas::TextureAtlas(CreateInfo const& create_info) : m_info(create_info) {
+	m_info.page_size = {std::max(m_info.page_size.x, 1), std::max(m_info.page_size.y, 1)};
+	m_info.padding = std::max(m_info.padding, 0);
+	m_info.max_pages = std::max(m_info.max_pages, 1u);
+}
+
+auto TextureAtlas::add(Bitmap const& bitmap) -> std::optional<AtlasId> {
+	if (!is_valid(bitmap)) { return {}; }
+
+	auto const placement = place(m_pages, bitmap.size);
+	if (!placement) { return {}; }
+
+	write(m_pages.at(placement->page), placement->left_top, bitmap);
+	auto const entry = make_entry(*placement, bitmap.size);
+
+	if (!m_free_ids.empty()) {
+		auto const ret = m_free_ids.back();
+		m_free_ids.pop_back();
+		m_entries.at(std::size_t(ret)) = entry;
+		return ret;
+	}
+
+	auto const ret = AtlasId(m_entries.size());
+	m_entries.emplace_back(entry);
+	return ret;
+}
+
+auto TextureAtlas::remove(AtlasId const id) -> bool {
+	auto const index = std::size_t(id);
+	if (index >= m_entries.size() || !m_entries[index]) { return false; }
+	m_entries[index].reset();
+	m_free_ids.push_back(id);
+	return true;
+}
+
+auto TextureAtlas::repack() -> bool {
+	struct Source {
+		std::size_t index{};
+		ColorBitmap bitmap{};
+		glm::ivec2 size{};
+	};
+
+	auto sources = std::vector<Source>{};
+	sources.reserve(m_entries.size());
+	for (std::size_t index = 0; index < m_entries.size(); ++index) {
+		auto const& entry = m_entries[index];
+		if (!entry) { continue; }
+		sources.push_back(Source{.index = index, .bitmap = read(*entry), .size = entry->rect.rb - entry->rect.lt});
+	}
+	std::ranges::sort(sources, [](Source const& a, Source const& b) { return a.size.y > b.size.y || (a.size.y == b.size.y && a.size.x > b.size.x); });
+
+	auto pages = std::vector<Page>{};
+	auto entries = std::vector<std::optional<AtlasEntry>>(m_entries.size());
+	for (auto const& source : sources) {
+		auto const placement = place(pages, source.size);
+		if (!placement) { return false; }
+		write(pages.at(placement->page), placement->left_top, source.bitmap.bitmap());
+		entries.at(source.index) = make_entry(*placement, source.size);
+	}
+
+	for (auto& page : pages) { page.dirty = true; }
+	m_pages = std::move(pages);
+	m_entries = std::move(entries);
+	return true;
+}
+
+void TextureAtlas::clear() {
+	m_pages.clear();
+	m_entries.clear();
+	m_free_ids.clear();
+}
+
+auto TextureAtlas::get_entry(AtlasId const id) const -> klib::Ptr<AtlasEntry const> {
+	auto const index = std::size_t(id);
+	if (index >= m_entries.size() || !m_entries[index]) { return {}; }
+	return &*m_entries[index];
+}
+
+auto TextureAtlas::get_entry_count() const -> std::size_t { return m_entries.size() - m_free_ids.size(); }
+
+void TextureAtlas::clear_dirty() {
+	for (auto& page : m_pages) { page.dirty = false; }
+}
+
+auto TextureAtlas::place(std::vector<Page>& pages, glm::ivec2 const size) const -> std::optional<Placement> {
+	auto const slot_size = size + (2 * m_info.padding);
+	if (slot_size.x > m_info.page_size.x || slot_size.y > m_info.page_size.y) { return {}; }
+
+	auto const place_in = [&](Page& page) -> std::optional<glm::ivec2> {
+		// best fit: shortest existing shelf that can hold this slot.
+		Shelf* best = nullptr;
+		for (auto& shelf : page.shelves) {
+			if (shelf.height < slot_size.y || shelf.cursor_x + slot_size.x > m_info.page_size.x) { continue; }
+			if (best == nullptr || shelf.height < best->height) { best = &shelf; }
+		}
+		if (best == nullptr) {
+			if (page.used_height + slot_size.y > m_info.page_size.y) { return {}; }
+			best = &page.shelves.emplace_back(Shelf{.y = page.used_height, .height = slot_size.y});
+			page.used_height += slot_size.y;
+		}
+		auto const ret = glm::ivec2{best->cursor_x, best->y};
+		best->cursor_x += slot_size.x;
+		return ret;
+	};
+
+	for (std::size_t index = 0; index < pages.size(); ++index) {
+		if (auto const left_top = place_in(pages[index])) { return Placement{.page = std::uint32_t(index), .left_top = *left_top}; }
+	}
+
+	if (pages.size() >= m_info.max_pages) { return {}; }
+	auto& page = pages.emplace_back();
+	page.bitmap = ColorBitmap{m_info.page_size};
+	auto const left_top = place_in(page);
+	if (!left_top) { return {}; }
+	return Placement{.page = std::uint32_t(pages.size() - 1), .left_top = *left_top};
+}
+
+auto TextureAtlas::make_entry(Placement const& placement, glm::ivec2 const size) const -> AtlasEntry {
+	auto const lt = placement.left_top + m_info.padding;
+	auto const rb = lt + size;
+	auto const fpage = glm::vec2{m_info.page_size};
+	return AtlasEntry{
+		.page = placement.page,
+		.rect = {.lt = lt, .rb = rb},
+		.uv_rect = {.lt = glm::vec2{lt} / fpage, .rb = glm::vec2{rb} / fpage},
+	};
+}
+
+void TextureAtlas::write(Page& page, glm::ivec2 const left_top, Bitmap const& bitmap) const {
+	auto const pad = m_info.padding;
+	auto const origin = left_top + pad;
+	auto const row_size = std::size_t(bitmap.size.x) * sizeof(Color);
+	auto& dst = page.bitmap;
+	for (int y = 0; y < bitmap.size.y; ++y) {
+		auto const src = bitmap.bytes.subspan(std::size_t(y) * row_size, row_size);
+		std::memcpy(&dst[origin.x, origin.y + y], src.data(), row_size);
+	}
+
+	if (m_info.extrude && pad > 0) {
+		auto const last = bitmap.size - 1;
+		auto const extrude_pixel = [&](int const x, int const y) {
+			dst[origin.x + x, origin.y + y] = dst[origin.x + std::clamp(x, 0, last.x), origin.y + std::clamp(y, 0, last.y)];
+		};
+		for (int y = -pad; y < bitmap.size.y + pad; ++y) {
+			if (y < 0 || y > last.y) {
+				for (int x = -pad; x < bitmap.size.x + pad; ++x) { extrude_pixel(x, y); }
+				continue;
+			}
+			for (int x = 1; x <= pad; ++x) {
+				extrude_pixel(-x, y);
+				extrude_pixel(last.x + x, y);
+			}
+		}
+	}
+
+	page.dirty = true;
+}
+
+auto TextureAtlas::read(AtlasEntry const& entry) const -> ColorBitmap {
+	auto const size = entry.rect.rb - entry.rect.lt;
+	auto ret = ColorBitmap{size};
+	auto const& src = m_pages.at(entry.page).bitmap;
+	for (int y = 0; y < size.y; ++y) {
+		std::memcpy(&ret[0, y], &src[entry.rect.lt.x, entry.rect.lt.y + y], std::size_t(size.x) * sizeof(Color));
+	}
+	return ret;
+}
+} // namespace kvf
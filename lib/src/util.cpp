@@ -95,6 +95,8 @@ void util::record_barriers(vk::CommandBuffer const command_buffer, std::span<vk:
 auto util::create_image_view(vk::Device const device, ImageViewCreateInfo const& create_info) -> vk::UniqueImageView {
 	auto image_view_ci = vk::ImageViewCreateInfo{};
 	image_view_ci.setImage(create_info.image).setFormat(create_info.format).setViewType(create_info.type).setSubresourceRange(create_info.subresource);
+	auto const usage_ci = vk::ImageViewUsageCreateInfo{create_info.usage};
+	if (create_info.usage) { image_view_ci.setPNext(&usage_ci); }
 	return device.createImageViewUnique(image_view_ci);
 }
 } // namespace kvf